@@ -0,0 +1,127 @@
+/**
+ * @file event_bus.h
+ * @brief Type-indexed event bus: one signal2 per event type.
+ *
+ * Built on top of signals2 (signals.h). Header-only. Each event type gets a
+ * small integer the first time it is used, so publish() is an array index
+ * plus a normal signal emission -- no RTTI, no std::type_index hashing, no
+ * std::any.
+ *
+ * Example:
+ *   struct MouseMoved { int x; int y; };
+ *
+ *   signals2::event_bus bus;
+ *   conns_.push_back(bus.subscribe<MouseMoved>([](const MouseMoved& e) { ... }));
+ *   bus.publish(MouseMoved{ 10, 20 });
+ *
+ * Lifetime and reentrancy follow signal2: subscribe() returns an owning
+ * connection, and a handler subscribed during publish() starts receiving with
+ * the next publish of that type.
+ *
+ * Threading: not thread-safe, like signals2 itself.
+ *
+ * Event indices are assigned per module, like the dependency tracking stack in
+ * state.h: do not share one bus between a publisher and a subscriber that live
+ * in different DLLs.
+ */
+
+#ifndef SIGNALS2_EVENT_BUS_H_
+#define SIGNALS2_EVENT_BUS_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "signals.h"
+
+namespace signals2 {
+
+namespace detail {
+
+inline std::size_t next_event_index() {
+  static std::size_t next = 0;
+  return next++;
+}
+
+/// Dense index of event type E, assigned on first use.
+template <typename E>
+std::size_t event_index() {
+  static const std::size_t index = next_event_index();
+  return index;
+}
+
+class event_channel_base {
+public:
+  virtual ~event_channel_base() = default;
+};
+
+template <typename E>
+class event_channel final : public event_channel_base {
+public:
+  signal2<void(const E&)> signal;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Routes events to per-type signals.
+ *
+ * Non-copyable and non-movable: connections keep referring to the signals the
+ * bus owns, and a moved-from bus would silently drop them.
+ */
+class event_bus {
+public:
+  event_bus() = default;
+
+  event_bus(const event_bus&) = delete;
+  event_bus& operator=(const event_bus&) = delete;
+  event_bus(event_bus&&) = delete;
+  event_bus& operator=(event_bus&&) = delete;
+
+  template <typename E>
+  using signal_type = signal2<void(const E&)>;
+
+  /// Connect @p handler to events of type E. Keep the connection alive.
+  template <typename E, typename F>
+  [[nodiscard]] connection subscribe(F&& handler) {
+    static_assert(std::is_same_v<E, std::decay_t<E>>, "subscribe to the plain event type");
+    return signal<E>().connect(std::function<void(const E&)>(std::forward<F>(handler)));
+  }
+
+  /// Emit @p event to every handler of its type. A type nobody ever subscribed
+  /// to costs one bounds check.
+  template <typename E>
+  void publish(const E& event) {
+    const std::size_t index = detail::event_index<E>();
+    if (index >= signals_.size() || !signals_[index]) {
+      return;
+    }
+    static_cast<detail::event_channel<E>*>(signals_[index].get())->signal(event);
+  }
+
+  /// The underlying signal for E, created on first use. Useful for iterating
+  /// handlers directly or forwarding it elsewhere.
+  template <typename E>
+  signal_type<E>& signal() {
+    const std::size_t index = detail::event_index<E>();
+    if (index >= signals_.size()) {
+      signals_.resize(index + 1);
+    }
+    if (!signals_[index]) {
+      signals_[index] = std::make_unique<detail::event_channel<E>>();
+    }
+    return static_cast<detail::event_channel<E>*>(signals_[index].get())->signal;
+  }
+
+private:
+  // Indexed by detail::event_index<E>(). The virtual destructor is the only
+  // type erasure; publish() casts straight back to the channel.
+  std::vector<std::unique_ptr<detail::event_channel_base>> signals_;
+};
+
+}  // namespace signals2
+
+#endif  // SIGNALS2_EVENT_BUS_H_
@@ -0,0 +1,123 @@
+/**
+ * @file instrument.h
+ * @brief Optional instrumentation of the signal hot path.
+ *
+ * Compiled in only when SIGNALS2_INSTRUMENT is defined (CMake option
+ * SIGNALS2_INSTRUMENT). Without it this header declares nothing but a no-op
+ * SIGNALS2_INSTRUMENT_HOOK, so signals.h generates the same code as if the
+ * instrumentation did not exist.
+ *
+ * With it, every signal carries a signal_stats block with its counters, and
+ * the hooks installed through instrument::install() are called on connect,
+ * disconnect, emission begin/end, each slot call, compaction and signal_lock
+ * allocation. A hook receives the stats block of the signal concerned; its
+ * address identifies the signal for as long as the signal lives. state.h
+ * reports observable::emit() and computed::recompute() passes the same way,
+ * identified by the object's address.
+ *
+ * SIGNALS2_INSTRUMENT changes the layout of the signal internals, so it must
+ * be defined identically in every translation unit of a program.
+ *
+ * Threading: hooks are installed globally. Install them before any signal is
+ * used, like signals2 itself they are not synchronized.
+ */
+
+#ifndef SIGNALS2_INSTRUMENT_H_
+#define SIGNALS2_INSTRUMENT_H_
+
+#if defined(SIGNALS2_INSTRUMENT)
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace signals2 {
+namespace instrument {
+
+/// Per-signal counters. Owned by the signal; read them through stats().
+struct signal_stats {
+  /// Optional label, set through set_name(). Not copied: must outlive the signal.
+  const char* name = nullptr;
+  std::uint64_t emits = 0;
+  std::uint64_t slot_calls = 0;
+  /// Disconnected slots still in the list because an emission was running.
+  std::uint64_t dead_slot_skips = 0;
+  std::uint64_t slot_nanoseconds = 0;
+};
+
+/// Null members are skipped.
+struct hooks {
+  void (*connect)(const signal_stats& signal) = nullptr;
+  void (*disconnect)(const signal_stats& signal) = nullptr;
+  void (*emit_begin)(const signal_stats& signal, std::size_t slots) = nullptr;
+  /// @p signal is nullptr when a slot destroyed the signal during the emission.
+  void (*emit_end)(const signal_stats* signal) = nullptr;
+  void (*slot_call)(const signal_stats& signal, std::uint64_t nanoseconds) = nullptr;
+  void (*compact)(const signal_stats& signal, std::size_t removed) = nullptr;
+  void (*lock_allocate)(const signal_stats& signal) = nullptr;
+  /// Outermost notification round of an observable (state.h), including the
+  /// pending rounds it flushes.
+  void (*observable_emit_begin)(const void* observable) = nullptr;
+  void (*observable_emit_end)(const void* observable) = nullptr;
+  void (*recompute_begin)(const void* computed) = nullptr;
+  void (*recompute_end)(const void* computed) = nullptr;
+};
+
+inline hooks installed_hooks;
+
+inline void install(const hooks& new_hooks) {
+  installed_hooks = new_hooks;
+}
+
+inline std::uint64_t now() {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Calls a begin/end hook pair around a scope, so the end hook also runs when
+/// a callback throws.
+template <void (*hooks::*Begin)(const void*), void (*hooks::*End)(const void*)>
+class scoped_span {
+public:
+  explicit scoped_span(const void* object) : object_(object) {
+    if (installed_hooks.*Begin) {
+      (installed_hooks.*Begin)(object_);
+    }
+  }
+
+  ~scoped_span() {
+    if (installed_hooks.*End) {
+      (installed_hooks.*End)(object_);
+    }
+  }
+
+  scoped_span(const scoped_span&) = delete;
+  scoped_span& operator=(const scoped_span&) = delete;
+
+private:
+  const void* object_;
+};
+
+}  // namespace instrument
+}  // namespace signals2
+
+#define SIGNALS2_INSTRUMENT_HOOK(hook, ...)                        \
+  do {                                                             \
+    if (::signals2::instrument::installed_hooks.hook) {            \
+      ::signals2::instrument::installed_hooks.hook(__VA_ARGS__);   \
+    }                                                              \
+  } while (0)
+
+#define SIGNALS2_INSTRUMENT_SPAN(begin, end, object)                                  \
+  ::signals2::instrument::scoped_span<&::signals2::instrument::hooks::begin,           \
+                                      &::signals2::instrument::hooks::end>             \
+      signals2_instrument_span_(object)
+
+#else
+
+#define SIGNALS2_INSTRUMENT_HOOK(hook, ...) ((void)0)
+#define SIGNALS2_INSTRUMENT_SPAN(begin, end, object) ((void)0)
+
+#endif  // SIGNALS2_INSTRUMENT
+
+#endif  // SIGNALS2_INSTRUMENT_H_
@@ -12,6 +12,8 @@
 #include <utility>
 #include <vector>
 
+#include "instrument.h"
+
 namespace signals2
 {
   template<int N>
@@ -88,12 +90,68 @@ namespace signals2
     template<typename... T>
     using function_traits = function_traits_helper<std::is_function<first<T...>>::value, T...>;
 
+    class disconnect_batch;
+
     struct connection_internal_base {
       virtual ~connection_internal_base() {
 
       }
 
       virtual bool connected() const = 0;
+
+      virtual void disconnect(disconnect_batch& batch) = 0;
+    };
+
+    // Collects the signals touched by a bulk disconnect so that each of them is
+    // compacted once, instead of paying one remove() per connection.
+    class disconnect_batch {
+    public:
+      disconnect_batch() = default;
+
+      disconnect_batch(const disconnect_batch&) = delete;
+
+      disconnect_batch& operator=(const disconnect_batch&) = delete;
+
+      ~disconnect_batch() {
+        flush();
+      }
+
+      template<typename S>
+      void defer_compact(std::shared_ptr<S>&& signal) {
+        S* key = signal.get();
+        // Connections to one signal usually come together; other repeats are
+        // dropped by flush().
+        if (!entries_.empty() && entries_.back().key == key) {
+          return;
+        }
+        entries_.push_back(entry{ key, std::move(signal), [](void* s) { static_cast<S*>(s)->compact_or_defer(); } });
+      }
+
+      void flush() {
+        std::vector<entry> entries;
+        entries.swap(entries_);
+        // Sorted by signal so that each is compacted once, in O(k log k) for k
+        // entries rather than a scan of the queue per entry.
+        std::sort(entries.begin(), entries.end(), [](const entry& lhs, const entry& rhs) {
+          return std::less<void*>()(lhs.key, rhs.key);
+        });
+        void* previous = nullptr;
+        for (entry& e : entries) {
+          if (e.key != previous) {
+            previous = e.key;
+            e.compact(e.key);
+          }
+        }
+      }
+
+    private:
+      struct entry {
+        void* key;
+        std::shared_ptr<void> keep_alive;
+        void (*compact)(void*);
+      };
+
+      std::vector<entry> entries_;
     };
 
     template<typename F>
@@ -339,6 +397,15 @@ namespace signals2
       lock_ptr<signal_lock<F>> lock_;
     };
 
+    // A signal-to-signal edge. The emission loop follows it directly instead of
+    // going through a slot that calls the downstream signal.
+    template<typename F>
+    struct forward_edge {
+      signal_detail<F>* target = nullptr;
+      std::weak_ptr<signal_detail<F>> alive;
+      bool connected = true;
+    };
+
     template<typename F>
     class signal_detail {
       friend class signal_lock<F>;
@@ -362,32 +429,28 @@ namespace signals2
 
       iterator begin() {
         if (!lock_) {
-          lock_ = new signal_lock<F>();
-          lock_->set_signal(this);
+          create_lock();
         }
         return iterator(0, lock_);
       }
 
       iterator end() {
         if (!lock_) {
-          lock_ = new signal_lock<F>();
-          lock_->set_signal(this);
+          create_lock();
         }
         return iterator(connections_.size(), lock_);
       }
 
       const_iterator cbegin() {
         if (!lock_) {
-          lock_ = new signal_lock<F>();
-          lock_->set_signal(this);
+          create_lock();
         }
         return const_iterator(0, lock_);
       }
 
       const_iterator cend() {
         if (!lock_) {
-          lock_ = new signal_lock<F>();
-          lock_->set_signal(this);
+          create_lock();
         }
         return const_iterator(connections_.size(), lock_);
       }
@@ -400,10 +463,40 @@ namespace signals2
         connections_.push_back(slot);
       }
 
+      std::vector<forward_edge<F>*>& forwards() {
+        return forwards_;
+      }
+
+      void forward(forward_edge<F>* edge) {
+        forwards_.push_back(edge);
+      }
+
+      void remove_forward(forward_edge<F>* edge) {
+        typename std::vector<forward_edge<F>*>::iterator it =
+          std::find(forwards_.begin(), forwards_.end(), edge);
+        if (it != forwards_.end()) {
+          forwards_.erase(it);
+        }
+      }
+
       void invalid() {
         lock_->invalid();
       }
 
+      bool empty() const {
+        for (slot2<F>* slot : connections_) {
+          if (*slot) {
+            return false;
+          }
+        }
+        for (forward_edge<F>* edge : forwards_) {
+          if (edge->connected) {
+            return false;
+          }
+        }
+        return true;
+      }
+
       void remove(slot2<F>* slot) {
         typename std::vector<slot2<F>*>::iterator it =
           std::find(connections_.begin(), connections_.end(), slot);
@@ -419,7 +512,19 @@ namespace signals2
         return lock_->locked();
       }
 
+      // A slot destructor run by a bulk disconnect may have started an emission.
+      void compact_or_defer() {
+        if (locked()) {
+          invalid();
+        } else {
+          compact();
+        }
+      }
+
       void compact() {
+#if defined(SIGNALS2_INSTRUMENT)
+        const size_t size_before = connections_.size() + forwards_.size();
+#endif
         typename std::vector<slot2<F>*>::iterator it_1 = connections_.begin();
         typename std::vector<slot2<F>*>::iterator it_2 = it_1;
         while (it_1 != connections_.end()) {
@@ -434,13 +539,56 @@ namespace signals2
           ++it_1;
         }
         connections_.erase(it_2, connections_.end());
+        forwards_.erase(std::remove_if(forwards_.begin(), forwards_.end(), [](forward_edge<F>* edge) {
+          if (edge->connected) {
+            return false;
+          }
+          delete edge;
+          return true;
+        }), forwards_.end());
+        SIGNALS2_INSTRUMENT_HOOK(compact, stats_, size_before - connections_.size() - forwards_.size());
+      }
+
+#if defined(SIGNALS2_INSTRUMENT)
+      instrument::signal_stats& stats() {
+        return stats_;
       }
+#endif
 
     private:
+      void create_lock() {
+        lock_ = new signal_lock<F>();
+        lock_->set_signal(this);
+        SIGNALS2_INSTRUMENT_HOOK(lock_allocate, stats_);
+      }
+
       std::vector<slot2<F>*> connections_;
+      std::vector<forward_edge<F>*> forwards_;
       signal_lock<F>* lock_ = nullptr;
+#if defined(SIGNALS2_INSTRUMENT)
+      instrument::signal_stats stats_;
+#endif
     };
 
+#ifndef NDEBUG
+    template<typename F>
+    bool forwards_reach(signal_detail<F>* from, const signal_detail<F>* to, std::vector<const signal_detail<F>*>& visited) {
+      if (from == to) {
+        return true;
+      }
+      if (std::find(visited.begin(), visited.end(), from) != visited.end()) {
+        return false;
+      }
+      visited.push_back(from);
+      for (forward_edge<F>* edge : from->forwards()) {
+        if (edge->connected && !edge->alive.expired() && forwards_reach(edge->target, to, visited)) {
+          return true;
+        }
+      }
+      return false;
+    }
+#endif
+
     template<typename F>
     struct signal_slot_connection : public connection_internal_base {
       std::weak_ptr<signal_detail<F>> the_signal;
@@ -454,9 +602,13 @@ namespace signals2
       }
 
       void disconnect() {
+        if (!the_slot) {
+          return;
+        }
         *the_slot = nullptr;
         std::shared_ptr<signal_detail<F>> signal = the_signal.lock();
         if (signal) {
+          SIGNALS2_INSTRUMENT_HOOK(disconnect, signal->stats());
           if (signal->locked()) {
             signal->invalid();
             the_slot.release();
@@ -467,6 +619,78 @@ namespace signals2
         the_slot.reset();
         the_signal.reset();
       }
+
+      // Leaves the emptied slot in the signal and hands it over; the batch
+      // compacts every touched signal once when it is flushed.
+      void disconnect(disconnect_batch& batch) override {
+        if (!the_slot) {
+          return;
+        }
+        *the_slot = nullptr;
+        std::shared_ptr<signal_detail<F>> signal = the_signal.lock();
+        if (signal) {
+          SIGNALS2_INSTRUMENT_HOOK(disconnect, signal->stats());
+          the_slot.release();
+          if (signal->locked()) {
+            signal->invalid();
+          } else {
+            batch.defer_compact(std::move(signal));
+          }
+        }
+        the_slot.reset();
+        the_signal.reset();
+      }
+    };
+
+    template<typename F>
+    struct signal_forward_connection : public connection_internal_base {
+      std::weak_ptr<signal_detail<F>> the_signal;
+      std::unique_ptr<forward_edge<F>> the_edge;
+      virtual ~signal_forward_connection() override {
+        disconnect();
+      }
+
+      bool connected() const override {
+        return !the_signal.expired();
+      }
+
+      void disconnect() {
+        if (!the_edge) {
+          return;
+        }
+        the_edge->connected = false;
+        std::shared_ptr<signal_detail<F>> signal = the_signal.lock();
+        if (signal) {
+          SIGNALS2_INSTRUMENT_HOOK(disconnect, signal->stats());
+          if (signal->locked()) {
+            signal->invalid();
+            the_edge.release();
+          } else {
+            signal->remove_forward(the_edge.get());
+          }
+        }
+        the_edge.reset();
+        the_signal.reset();
+      }
+
+      void disconnect(disconnect_batch& batch) override {
+        if (!the_edge) {
+          return;
+        }
+        the_edge->connected = false;
+        std::shared_ptr<signal_detail<F>> signal = the_signal.lock();
+        if (signal) {
+          SIGNALS2_INSTRUMENT_HOOK(disconnect, signal->stats());
+          the_edge.release();
+          if (signal->locked()) {
+            signal->invalid();
+          } else {
+            batch.defer_compact(std::move(signal));
+          }
+        }
+        the_edge.reset();
+        the_signal.reset();
+      }
     };
 
     template <std::size_t... Is, typename F, typename Tuple>
@@ -517,7 +741,14 @@ namespace signals2
     }
   }
 
+  class connection;
+
+  template<typename Range>
+  void disconnect_all(Range&& connections);
+
   class connection final {
+    template<typename Range>
+    friend void disconnect_all(Range&& connections);
   public:
     connection()
       : connection_detail_() {
@@ -537,6 +768,27 @@ namespace signals2
     std::unique_ptr<detail::connection_internal_base> connection_detail_;
   };
 
+  /**
+   * Disconnect every connection in @p connections, typically the
+   * std::vector<signals2::connection> an observer owns.
+   *
+   * Equivalent to calling disconnect() on each element, but a signal that
+   * loses several slots is compacted once instead of once per slot, which
+   * keeps tearing down a large set of bindings linear. The connections are
+   * left empty, so the range can be cleared or reused afterwards.
+   */
+  template<typename Range>
+  void disconnect_all(Range&& connections) {
+    detail::disconnect_batch batch;
+    for (connection& conn : connections) {
+      if (conn.connection_detail_) {
+        conn.connection_detail_->disconnect(batch);
+        conn.connection_detail_.reset();
+      }
+    }
+    batch.flush();
+  }
+
   template<typename R, typename... A>
   class signal_impl {
     using function_type = R(A...);
@@ -586,6 +838,7 @@ namespace signals2
       std::unique_ptr<detail::signal_slot_connection<function_type>> connection_detail(new detail::signal_slot_connection<function_type>());
       std::unique_ptr<detail::slot2<function_type>> the_slot(new detail::slot2<function_type>(the_function));
       signal_detail_->connect(the_slot.get());
+      SIGNALS2_INSTRUMENT_HOOK(connect, signal_detail_->stats());
       connection_detail->the_signal = signal_detail_;
       connection_detail->the_slot = std::move(the_slot);
       connection result(std::move(connection_detail));
@@ -597,6 +850,7 @@ namespace signals2
       std::unique_ptr<detail::signal_slot_connection<function_type>> connection_detail(new detail::signal_slot_connection<function_type>());
       std::unique_ptr<detail::slot2<function_type>> the_slot(new detail::slot2<function_type>(std::move(the_function)));
       signal_detail_->connect(the_slot.get());
+      SIGNALS2_INSTRUMENT_HOOK(connect, signal_detail_->stats());
       connection_detail->the_signal = signal_detail_;
       connection_detail->the_slot = std::move(the_slot);
       connection result(std::move(connection_detail));
@@ -621,26 +875,135 @@ namespace signals2
         });
     }
 
+    /**
+     * Relay every emission of this signal into @p downstream, after this
+     * signal's own slots have run. The edge is followed directly by the
+     * emission loop; there is no intermediate slot. Forwarding cycles are a
+     * usage error and are asserted against in debug builds.
+     *
+     * @return connection owning the edge; disconnecting it removes the edge.
+     */
+    [[nodiscard]] connection forward_to(signal_impl& downstream) {
+      create_shared_block();
+      downstream.create_shared_block();
+      assert(!forms_cycle(downstream) && "signals2::signal_impl::forward_to() would create a forwarding cycle");
+      std::unique_ptr<detail::signal_forward_connection<function_type>> connection_detail(new detail::signal_forward_connection<function_type>());
+      std::unique_ptr<detail::forward_edge<function_type>> the_edge(new detail::forward_edge<function_type>());
+      the_edge->target = downstream.signal_detail_.get();
+      the_edge->alive = downstream.signal_detail_;
+      signal_detail_->forward(the_edge.get());
+      SIGNALS2_INSTRUMENT_HOOK(connect, signal_detail_->stats());
+      connection_detail->the_signal = signal_detail_;
+      connection_detail->the_edge = std::move(the_edge);
+      connection result(std::move(connection_detail));
+      return result;
+    }
+
+    /// True when no slot and no forward edge is connected.
+    bool empty() const {
+      return !signal_detail_ || signal_detail_->empty();
+    }
+
     void operator()(A... param) {
       if (!signal_detail_) {
         return;
       }
       std::weak_ptr<detail::signal_detail<function_type>> alive = signal_detail_;
-      const_iterator it = cbegin();
+      detail::signal_detail<function_type>* the_signal = signal_detail_.get();
+      const_iterator it = the_signal->cbegin();
       // Connections added by a callback start receiving on the next emission.
-      const_iterator end_it = cend();
+      const_iterator end_it = the_signal->cend();
+      const size_t forward_count = the_signal->forwards().size();
+      SIGNALS2_INSTRUMENT_HOOK(emit_begin, the_signal->stats(), the_signal->connections().size());
+      if (emit_slots(the_signal, it, end_it, alive, param...) && forward_count != 0) {
+        emit_forwards(the_signal, alive, forward_count, param...);
+      }
+      SIGNALS2_INSTRUMENT_HOOK(emit_end, alive.expired() ? nullptr : &the_signal->stats());
+    }
+
+#if defined(SIGNALS2_INSTRUMENT)
+    /// Counters of this signal; nullptr until it is first connected or iterated.
+    const instrument::signal_stats* stats() const {
+      return signal_detail_ ? &signal_detail_->stats() : nullptr;
+    }
+
+    /// Label reported to the instrumentation hooks. @p name is not copied.
+    void set_name(const char* name) {
+      create_shared_block();
+      signal_detail_->stats().name = name;
+    }
+#endif
+
+  private:
+    // @return false if a slot destroyed the signal.
+    static bool emit_slots(detail::signal_detail<function_type>* the_signal, const_iterator& it, const const_iterator& end_it, const std::weak_ptr<detail::signal_detail<function_type>>& alive, A&... param) {
+#if defined(SIGNALS2_INSTRUMENT)
+      ++the_signal->stats().emits;
+#else
+      (void)the_signal;
+#endif
       while (it != end_it) {
         if (*it) {
+#if defined(SIGNALS2_INSTRUMENT)
+          const std::uint64_t started = instrument::now();
           (*it)(param...);
           if (alive.expired()) {
-            break;
+            return false;
           }
+          const std::uint64_t elapsed = instrument::now() - started;
+          ++the_signal->stats().slot_calls;
+          the_signal->stats().slot_nanoseconds += elapsed;
+          SIGNALS2_INSTRUMENT_HOOK(slot_call, the_signal->stats(), elapsed);
+#else
+          (*it)(param...);
+          if (alive.expired()) {
+            return false;
+          }
+#endif
+        }
+#if defined(SIGNALS2_INSTRUMENT)
+        else {
+          ++the_signal->stats().dead_slot_skips;
         }
+#endif
         ++it;
       }
+      return true;
     }
 
-  private:
+    // Only this function recurses, so operator() stays a flat loop the compiler
+    // can inline. The caller's iterators still hold the lock, so edges removed
+    // meanwhile stay in place, marked disconnected, until it unwinds.
+    static void emit_forwards(detail::signal_detail<function_type>* the_signal, const std::weak_ptr<detail::signal_detail<function_type>>& alive, size_t forward_count, A&... param) {
+      for (size_t i = 0; i < forward_count; ++i) {
+        detail::forward_edge<function_type>* edge = the_signal->forwards()[i];
+        if (!edge->connected || edge->alive.expired()) {
+          continue;
+        }
+        // Copied: a slot downstream may disconnect the edge that led here.
+        std::weak_ptr<detail::signal_detail<function_type>> target_alive = edge->alive;
+        detail::signal_detail<function_type>* target = edge->target;
+        const_iterator it = target->cbegin();
+        const_iterator end_it = target->cend();
+        const size_t target_forward_count = target->forwards().size();
+        SIGNALS2_INSTRUMENT_HOOK(emit_begin, target->stats(), target->connections().size());
+        if (emit_slots(target, it, end_it, target_alive, param...) && target_forward_count != 0) {
+          emit_forwards(target, target_alive, target_forward_count, param...);
+        }
+        SIGNALS2_INSTRUMENT_HOOK(emit_end, target_alive.expired() ? nullptr : &target->stats());
+        if (alive.expired()) {
+          return;
+        }
+      }
+    }
+
+#ifndef NDEBUG
+    bool forms_cycle(signal_impl& downstream) {
+      std::vector<const detail::signal_detail<function_type>*> visited;
+      return detail::forwards_reach(downstream.signal_detail_.get(), signal_detail_.get(), visited);
+    }
+#endif
+
     void create_shared_block() {
       if (!signal_detail_) {
         signal_detail_ = std::make_shared<detail::signal_detail<function_type>>();
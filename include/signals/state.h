@@ -10,7 +10,9 @@
  *   observable<T>  read-only interface; use as a parameter type
  *   state<T, Equal>    writable source of truth
  *   computed<T, Equal> read-only derived value, dependencies discovered automatically
+ *   lazy_computed<T, Equal> computed that recomputes on read while unobserved
  *   always_notify       equality policy that notifies on every set/recompute
+ *   batch / transaction defer notifications to the end of a scope
  *
  * Example:
  *   struct Model {
@@ -29,7 +31,9 @@
  * Lifetime: a connect() call returns a connection; whoever owns the callback
  * target must own that connection. Store them in a plain
  * std::vector<signals2::connection> member -- connection is move-only, so the
- * vector is non-copyable, and everything disconnects on destruction. Never
+ * vector is non-copyable, and everything disconnects on destruction. Pass the
+ * vector to signals2::disconnect_all() first when it holds many bindings; it
+ * compacts each signal once instead of once per connection. Never
  * store a connection in the object being observed -- that ties the
  * subscription to the wrong lifetime.
  *
@@ -41,6 +45,10 @@
  * are skipped, and the latest stable value is delivered before the outermost
  * update returns. Use signal2 directly when every transient event matters.
  *
+ * Propagation is glitch-free: computeds recompute in order of their height in
+ * the dependency graph, each at most once per update, so a computed fed by
+ * two paths from one state never publishes a mix of old and new inputs.
+ *
  * Cycles: a computed whose own output feeds back into one of its dependencies
  * is a usage error. Feedback that settles is supported. An unbounded cycle may
  * exhaust the stack or loop; this class deliberately does not impose a
@@ -69,8 +77,10 @@
 #define SIGNALS2_STATE_H_
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <type_traits>
@@ -79,8 +89,26 @@
 
 #include "signals.h"
 
+// Keeps a slow path out of the function that calls it, so the fast path is
+// not compiled with the slow path's register pressure.
+#if defined(_MSC_VER)
+#define SIGNALS2_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+#define SIGNALS2_NOINLINE __attribute__((noinline))
+#else
+#define SIGNALS2_NOINLINE
+#endif
+
 namespace signals2 {
 
+/// Evaluation policy of computed: recompute as soon as a dependency changes.
+struct eager_evaluation {};
+
+/// Evaluation policy of computed: while nothing is connected, a dependency
+/// change only marks the value out of date, and the next get()/peek()
+/// recomputes it. With a subscriber it behaves like eager_evaluation.
+struct lazy_evaluation {};
+
 /// Equality policy for values that cannot or should not be compared. Returning
 /// false means every set/recompute is treated as a change and notifies.
 struct always_notify {
@@ -92,43 +120,492 @@ struct always_notify {
 
 namespace detail {
 
+class dependency_tracker;
+
+/// An edge as the observable sees it: a computed that reads it.
+struct dependent_edge {
+  dependency_tracker* tracker;
+  /// Position of the other half in the tracker's dependency list.
+  std::uint32_t position;
+};
+
+/**
+ * @brief The computeds reading an observable, kept apart from its subscribers.
+ *
+ * Notifying them is a direct call per edge -- no slot, no std::function. It
+ * runs no user code either: on_dependency_changed() only marks and queues, so
+ * the list never changes while it is walked, and an edge can be unlinked at
+ * any other time, from either end.
+ */
+class dependent_list {
+public:
+  dependent_list() = default;
+  dependent_list(const dependent_list&) = delete;
+  dependent_list& operator=(const dependent_list&) = delete;
+
+  /// Cuts every edge; the computeds keep their last value.
+  ~dependent_list();
+
+  bool empty() const { return edges_.empty(); }
+
+  void notify(std::uint32_t source_height) const;
+
+private:
+  friend class dependency_tracker;
+
+  std::vector<dependent_edge> edges_;
+};
+
 /**
- * @brief Sink for dependencies discovered while a compute function runs.
+ * @brief Sink for dependencies discovered while a compute function runs, and
+ *        the computed's place in the update order.
  *
  * Implemented by computed. Never part of the public contract: the tracking
  * mechanism must stay replaceable.
+ *
+ * Height is the topological height in the dependency graph: a state is 0, a
+ * computed is one above the highest dependency it has seen. It is raised when
+ * a deeper dependency is discovered or reports a change, never lowered.
+ *
+ * Each dependency is one edge, held in two halves: a dependent_edge in the
+ * observable's dependent_list and a dependency_edge here, each knowing the
+ * position of the other, so either end unlinks it in O(1).
  */
 class dependency_tracker {
 public:
-  virtual void on_dependency_changed() = 0;
-  virtual void add_dependency(signals2::connection&& connection) = 0;
-  /// @return true if @p dependency was not tracked yet (caller should subscribe)
-  virtual bool try_mark_tracked(const void* dependency) = 0;
+  /// @param source_height height of the observable that changed
+  virtual void on_dependency_changed(std::uint32_t source_height) = 0;
+  /// Run the queued recompute now, if there still is one.
+  virtual void refresh() = 0;
+
+  /// Record a read of @p source by the running pass, linking it on the first.
+  void track(dependent_list& source, std::uint32_t source_height);
+
+  std::uint32_t height() const { return height_; }
+  /// A dependency changed and the recompute has not run yet.
+  bool dirty() const { return dirty_; }
 
 protected:
-  ~dependency_tracker() = default;
+  dependency_tracker() = default;
+  ~dependency_tracker();
+
+  dependency_tracker(const dependency_tracker&) = delete;
+  dependency_tracker& operator=(const dependency_tracker&) = delete;
+
+  /**
+   * After a pass that stands, unlink every dependency it did not read -- a
+   * branch of the compute function that stopped being taken. Safe at any
+   * point: dependents are notified by direct calls that run no user code, so
+   * no edge is ever being walked while a pass runs.
+   */
+  void release_unread(std::uint64_t pass);
+
+  void raise_height(std::uint32_t height);
+
+  std::uint32_t height_ = 0;
+  /// Entries of this tracker in the update queue, stale ones included.
+  std::uint32_t queued_ = 0;
+  bool dirty_ = false;
+  /// The update queue holds an entry at height_ that has not been popped.
+  bool scheduled_ = false;
+  /// Claimed by each compute pass; dependencies are stamped with it.
+  std::uint64_t epoch_ = 0;
+
+private:
+  friend class update_queue;
+  friend class dependent_list;
+
+  struct dependency_edge {
+    /// nullptr once the observable is destroyed.
+    dependent_list* source;
+    /// Position of the other half in source->edges_.
+    std::uint32_t position;
+    /// Epoch of the last pass that read it, truncated.
+    std::uint32_t pass;
+  };
+
+  void unlink(const dependency_edge& dependency);
+
+  // ---- dependency lookup ----
+  //
+  // Up to linear_dependencies, dependencies_ is scanned. Past that, index_ is
+  // an open-addressing table of positions in dependencies_ (plus one; 0 is an
+  // empty slot), at most half full, so a read inside the compute function
+  // costs O(1) however many states it aggregates.
+
+  static constexpr std::size_t linear_dependencies = 16;
+
+  /// Position of @p source in dependencies_, or dependencies_.size().
+  std::size_t find_dependency(const dependent_list* source) const {
+    if (index_.empty()) {
+      for (std::size_t i = 0; i < dependencies_.size(); ++i) {
+        if (dependencies_[i].source == source) {
+          return i;
+        }
+      }
+      return dependencies_.size();
+    }
+    const std::size_t mask = index_.size() - 1;
+    for (std::size_t slot = index_slot(source);; slot = (slot + 1) & mask) {
+      const std::uint32_t entry = index_[slot];
+      if (entry == 0) {
+        return dependencies_.size();
+      }
+      if (dependencies_[entry - 1].source == source) {
+        return entry - 1;
+      }
+    }
+  }
+
+  /// Add dependencies_[position] to index_, growing it first if needed.
+  void index_dependency(std::size_t position) {
+    if (dependencies_.size() <= linear_dependencies) {
+      return;
+    }
+    if (index_.size() < 2 * dependencies_.size()) {
+      rebuild_index();
+      return;
+    }
+    insert_index(position);
+  }
+
+  void rebuild_index() {
+    if (dependencies_.size() <= linear_dependencies) {
+      index_.clear();
+      return;
+    }
+    index_.assign(std::bit_ceil(4 * dependencies_.size()), 0);
+    for (std::size_t i = 0; i < dependencies_.size(); ++i) {
+      insert_index(i);
+    }
+  }
+
+  void insert_index(std::size_t position) {
+    const std::size_t mask = index_.size() - 1;
+    std::size_t slot = index_slot(dependencies_[position].source);
+    while (index_[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    index_[slot] = static_cast<std::uint32_t>(position + 1);
+  }
+
+  /// Fibonacci hashing: the top bits of the product, which every address bit
+  /// reaches -- the low bits of an address are mostly alignment.
+  std::size_t index_slot(const dependent_list* source) const {
+    const std::uint64_t hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(source)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<std::size_t>(hash >> (64 - std::countr_zero(index_.size())));
+  }
+
+  std::vector<dependency_edge> dependencies_;
+  std::vector<std::uint32_t> index_;
+};
+
+struct update_counters {
+  std::size_t emit_depth = 0;
+  /// Entries queued, stale ones included.
+  std::size_t size = 0;
+  /// No bucket below this one holds an entry.
+  std::size_t lowest = SIZE_MAX;
+  bool draining = false;
 };
 
-/// A stack, not a single slot, so nested computed evaluation nests correctly.
-inline std::vector<dependency_tracker*>& tracking_stack() {
-  static thread_local std::vector<dependency_tracker*> stack;
-  return stack;
+/**
+ * @brief Dirty computeds waiting to recompute, lowest height first.
+ *
+ * A dependency change only marks the computed dirty and queues it. The queue
+ * drains when the outermost observable::emit() on this thread returns, so a
+ * computed reached through several paths recomputes once, after every one of
+ * its dependencies has settled. One bucket per height, first in first out
+ * within a bucket: push and pop are O(1).
+ *
+ * A computed whose height is raised while queued is queued again at the new
+ * height; the old entry is stale and skipped. So is the entry of a computed
+ * that get() already refreshed.
+ *
+ * All static: the counters emit() touches on every call are a trivial
+ * thread_local, so the hot path pays no thread_local initialization check.
+ */
+class update_queue {
+public:
+  static void push(dependency_tracker* node) {
+    std::vector<bucket>& buckets = all_buckets();
+    const std::size_t height = node->height_;
+    if (height >= buckets.size()) {
+      buckets.resize(height + 1);
+    }
+    buckets[height].nodes.push_back(node);
+    counters_.lowest = std::min(counters_.lowest, height);
+    ++counters_.size;
+    ++node->queued_;
+    node->scheduled_ = true;
+  }
+
+  /// Called by a computed destroyed while queued.
+  static void remove(dependency_tracker* node) {
+    for (bucket& b : all_buckets()) {
+      const auto first = b.nodes.begin() + static_cast<std::ptrdiff_t>(b.head);
+      const auto last = std::remove(first, b.nodes.end(), node);
+      counters_.size -= static_cast<std::size_t>(b.nodes.end() - last);
+      b.nodes.erase(last, b.nodes.end());
+    }
+    node->queued_ = 0;
+    node->scheduled_ = false;
+  }
+
+  static void enter_emit() { ++counters_.emit_depth; }
+  static void leave_emit() { --counters_.emit_depth; }
+
+  /// Drain unless an emission or a drain further up the stack will.
+  static void flush() {
+    if (counters_.size != 0 && counters_.emit_depth == 0 && !counters_.draining) {
+      drain();
+    }
+  }
+
+private:
+  struct bucket {
+    std::vector<dependency_tracker*> nodes;
+    std::size_t head = 0;
+  };
+
+  static std::vector<bucket>& all_buckets() {
+    static thread_local std::vector<bucket> buckets;
+    return buckets;
+  }
+
+  static void drain() {
+    struct drain_guard {
+      ~drain_guard() { counters_.draining = false; }
+    };
+
+    counters_.draining = true;
+    drain_guard guard;
+    std::vector<bucket>& buckets = all_buckets();
+    while (counters_.size != 0) {
+      // Re-indexed every time: refresh() may push, to any height.
+      const std::size_t height = counters_.lowest;
+      bucket& b = buckets[height];
+      if (b.head == b.nodes.size()) {
+        b.nodes.clear();
+        b.head = 0;
+        ++counters_.lowest;
+        continue;
+      }
+      dependency_tracker* node = b.nodes[b.head++];
+      --counters_.size;
+      // Before refresh(): a subscriber may destroy the computed.
+      --node->queued_;
+      if (node->height_ == height) {
+        node->scheduled_ = false;
+        if (node->dirty_) {
+          node->refresh();
+        }
+      }
+    }
+    buckets[counters_.lowest].nodes.clear();
+    buckets[counters_.lowest].head = 0;
+    counters_.lowest = SIZE_MAX;
+  }
+
+  static constinit inline thread_local update_counters counters_{};
+};
+
+inline dependent_list::~dependent_list() {
+  for (const dependent_edge& edge : edges_) {
+    edge.tracker->dependencies_[edge.position].source = nullptr;
+  }
 }
 
-inline dependency_tracker* current_tracker() {
-  std::vector<dependency_tracker*>& stack = tracking_stack();
-  return stack.empty() ? nullptr : stack.back();
+inline void dependent_list::notify(std::uint32_t source_height) const {
+  for (const dependent_edge& edge : edges_) {
+    edge.tracker->on_dependency_changed(source_height);
+  }
+}
+
+inline dependency_tracker::~dependency_tracker() {
+  for (const dependency_edge& dependency : dependencies_) {
+    if (dependency.source) {
+      unlink(dependency);
+    }
+  }
+}
+
+inline void dependency_tracker::track(dependent_list& source, std::uint32_t source_height) {
+  const std::uint32_t pass = static_cast<std::uint32_t>(epoch_);
+  const std::size_t position = find_dependency(&source);
+  if (position != dependencies_.size()) {
+    dependencies_[position].pass = pass;
+    return;
+  }
+  source.edges_.push_back(dependent_edge{ this, static_cast<std::uint32_t>(position) });
+  dependencies_.push_back(dependency_edge{ &source, static_cast<std::uint32_t>(source.edges_.size() - 1), pass });
+  index_dependency(position);
+  raise_height(source_height + 1);
+}
+
+inline void dependency_tracker::release_unread(std::uint64_t pass) {
+  const std::uint32_t read = static_cast<std::uint32_t>(pass);
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < dependencies_.size(); ++i) {
+    const dependency_edge dependency = dependencies_[i];
+    if (dependency.pass != read) {
+      if (dependency.source) {
+        unlink(dependency);
+      }
+      continue;
+    }
+    if (kept != i) {
+      dependencies_[kept] = dependency;
+      if (dependency.source) {
+        dependency.source->edges_[dependency.position].position = static_cast<std::uint32_t>(kept);
+      }
+    }
+    ++kept;
+  }
+  if (kept != dependencies_.size()) {
+    dependencies_.resize(kept);
+    rebuild_index();
+  }
+}
+
+inline void dependency_tracker::unlink(const dependency_edge& dependency) {
+  std::vector<dependent_edge>& edges = dependency.source->edges_;
+  if (dependency.position + 1 != edges.size()) {
+    const dependent_edge moved = edges.back();
+    edges[dependency.position] = moved;
+    moved.tracker->dependencies_[moved.position].position = dependency.position;
+  }
+  edges.pop_back();
+}
+
+inline void dependency_tracker::raise_height(std::uint32_t height) {
+  if (height <= height_) {
+    return;
+  }
+  height_ = height;
+  if (scheduled_) {
+    // The queued entry is stale now.
+    scheduled_ = false;
+    if (dirty_) {
+      update_queue::push(this);
+    }
+  }
 }
 
+struct batch_counters {
+  std::size_t depth = 0;
+  bool flushing = false;
+};
+
+/**
+ * @brief Observables whose notification a signals2::batch has put off.
+ *
+ * Each observable is listed once, in the order it first changed, and marks
+ * itself so a second change inside the batch costs nothing. The outermost
+ * batch to end emits them all inside one update: every observable notifies
+ * once, and the computeds they dirty drain once, in height order, after the
+ * last of them.
+ */
+class deferred_emits {
+public:
+  using emit_function = void (*)(void* observable);
+
+  static bool active() { return counters_.depth != 0; }
+
+  static void open() { ++counters_.depth; }
+
+  static void close() {
+    if (--counters_.depth == 0 && !counters_.flushing) {
+      flush();
+    }
+  }
+
+  static void push(void* observable, emit_function emit) {
+    entries().push_back(entry{ observable, emit });
+  }
+
+  /// Called by an observable destroyed while listed.
+  static void remove(const void* observable) {
+    for (entry& e : entries()) {
+      if (e.observable == observable) {
+        // Not erased: flush() may be walking the list.
+        e.observable = nullptr;
+      }
+    }
+  }
+
+private:
+  struct entry {
+    void* observable;
+    emit_function emit;
+  };
+
+  static std::vector<entry>& entries() {
+    static thread_local std::vector<entry> list;
+    return list;
+  }
+
+  static void flush() {
+    // A batch opened and closed by a subscriber during the flush lists its
+    // observables here too; this loop picks them up.
+    struct flush_guard {
+      std::vector<entry>& list;
+      std::size_t& done;
+
+      ~flush_guard() {
+        // Entries left after a throwing subscriber go out with the next batch.
+        list.erase(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(done));
+        counters_.flushing = false;
+        update_queue::leave_emit();
+      }
+    };
+
+    std::vector<entry>& list = entries();
+    std::size_t done = 0;
+    counters_.flushing = true;
+    update_queue::enter_emit();
+    {
+      flush_guard guard{list, done};
+      while (done != list.size()) {
+        const entry next = list[done++];
+        if (next.observable) {
+          next.emit(next.observable);
+        }
+      }
+    }
+    update_queue::flush();
+  }
+
+  static constinit inline thread_local batch_counters counters_{};
+};
+
+/**
+ * A stack, not a single slot, so nested computed evaluation nests correctly:
+ * each scope keeps the tracker it replaced and restores it. The top is a
+ * constinit thread_local pointer, so the read outside any compute function --
+ * nearly every get() -- is one load with no thread_local initialization
+ * check.
+ */
 class tracking_scope {
 public:
-  explicit tracking_scope(dependency_tracker* tracker) { tracking_stack().push_back(tracker); }
-  ~tracking_scope() { tracking_stack().pop_back(); }
+  explicit tracking_scope(dependency_tracker* tracker) : previous_(current_) { current_ = tracker; }
+  ~tracking_scope() { current_ = previous_; }
 
   tracking_scope(const tracking_scope&) = delete;
   tracking_scope& operator=(const tracking_scope&) = delete;
+
+  static dependency_tracker* current() { return current_; }
+
+private:
+  dependency_tracker* previous_;
+
+  static constinit inline thread_local dependency_tracker* current_ = nullptr;
 };
 
+inline dependency_tracker* current_tracker() {
+  return tracking_scope::current();
+}
+
 }  // namespace detail
 
 /**
@@ -154,18 +631,19 @@ public:
    *        being evaluated right now.
    */
   const T& get() const {
-    if (detail::dependency_tracker* tracker = detail::current_tracker()) {
-      if (tracker->try_mark_tracked(this)) {
-        tracker->add_dependency(sig_.connect(
-            callback_type([tracker](const T&) { tracker->on_dependency_changed(); })));
-      }
+    refresh_if_dirty();
+    if (detail::dependency_tracker* tracker = detail::current_tracker()) [[unlikely]] {
+      track_read(tracker);
     }
     return value_;
   }
 
   /// Read without registering a dependency. Use inside a compute function for
   /// values that should not trigger a recompute.
-  const T& peek() const { return value_; }
+  const T& peek() const {
+    refresh_if_dirty();
+    return value_;
+  }
 
   /**
    * @brief Connect a callable taking either (const T&) or no arguments.
@@ -193,7 +671,10 @@ public:
       callback = [f = std::forward<F>(fn)](const T&) mutable { f(); };
     }
 
-    return sig_.connect(std::move(callback));
+    // A lazy computed nobody has read yet has no dependencies to wake it.
+    // Evaluating it now links them, so the new subscriber hears of changes.
+    refresh_if_dirty();
+    return watchers().sig.connect(std::move(callback));
   }
 
   /**
@@ -225,49 +706,168 @@ protected:
   explicit observable(std::in_place_t, Args&&... args)
       : value_(std::forward<Args>(args)...) {}
 
-  ~observable() = default;
+  ~observable() {
+    if (deferred_) {
+      detail::deferred_emits::remove(this);
+    }
+    if (!computed_) {
+      delete observers_;
+    }
+  }
 
   void emit() {
     ++revision_;
 
+    if (detail::deferred_emits::active()) {
+      if (!deferred_) {
+        deferred_ = true;
+        detail::deferred_emits::push(this, &observable::emit_deferred);
+      }
+      return;
+    }
+    // Notifying now delivers whatever a batch had put off.
+    deferred_ = false;
+
     if (emitting_) {
       pending_emit_ = true;
       return;
     }
 
+    // A computed always has its block; an empty one means nobody to tell
+    // either.
+    if (!observers_ || (computed_ && !observed())) {
+      // Nobody to tell. Still a notification round to instrumentation.
+      SIGNALS2_INSTRUMENT_SPAN(observable_emit_begin, observable_emit_end, this);
+      return;
+    }
+
     struct notification_guard {
-      bool& emitting;
-      bool& pending;
+      observable& self;
 
       ~notification_guard() {
-        pending = false;
-        emitting = false;
+        self.pending_emit_ = false;
+        self.emitting_ = false;
+        detail::update_queue::leave_emit();
       }
     };
 
-    emitting_ = true;
-    notification_guard guard{emitting_, pending_emit_};
-    do {
-      pending_emit_ = false;
-      const std::uint64_t emitted_revision = revision_;
-
-      auto it = sig_.cbegin();
-      // Connections added by a callback start receiving on the next emission.
-      const auto end_it = sig_.cend();
-      while (emitted_revision == revision_ && it != end_it) {
-        if (*it) {
-          (*it)(value_);
+    {
+      SIGNALS2_INSTRUMENT_SPAN(observable_emit_begin, observable_emit_end, this);
+      emitting_ = true;
+      detail::update_queue::enter_emit();
+      notification_guard guard{*this};
+      observers& watching = *observers_;
+      do {
+        pending_emit_ = false;
+        const std::uint16_t emitted_revision = revision_;
+        // Mark the computeds reading this first, so a subscriber reading one
+        // of them gets it refreshed.
+        watching.dependents.notify(computed_ ? node()->height() : 0);
+
+        auto it = watching.sig.cbegin();
+        // Connections added by a callback start receiving on the next emission.
+        const auto end_it = watching.sig.cend();
+        while (emitted_revision == revision_ && it != end_it) {
+          // A subscriber changed a dependency of this computed: recompute
+          // before the next subscriber is handed the obsolete value. A new
+          // value bumps the revision and ends this round.
+          if (computed_ && node()->dirty()) {
+            node()->refresh();
+            continue;
+          }
+          if (*it) {
+            (*it)(value_);
+          }
+          ++it;
         }
-        ++it;
-      }
-    } while (pending_emit_);
+      } while (pending_emit_);
+    }
+    // Not reached when a callback throws: the queued computeds stay dirty
+    // and recompute on the next read or update.
+    detail::update_queue::flush();
   }
 
+  static void emit_deferred(void* self) {
+    observable* target = static_cast<observable*>(self);
+    if (target->deferred_) {
+      target->emit();
+    }
+  }
+
+  /// Recompute first if this is a computed with a pending update, so a read
+  /// never sees a value its dependencies have already moved past. A loop: a
+  /// compute function that writes its own dependency supersedes its pass.
+  void refresh_if_dirty() const {
+    if (computed_ && node()->dirty()) [[unlikely]] {
+      refresh_dirty();
+    }
+  }
+
+  SIGNALS2_NOINLINE void refresh_dirty() const {
+    detail::dependency_tracker* node = this->node();
+    do {
+      node->refresh();
+    } while (node->dirty());
+  }
+
+  SIGNALS2_NOINLINE void track_read(detail::dependency_tracker* tracker) const {
+    tracker->track(watchers().dependents, computed_ ? node()->height() : 0);
+  }
+
+  /// A subscriber or a computed would see a change.
+  bool observed() const {
+    return observers_ && (!observers_->sig.empty() || !observers_->dependents.empty());
+  }
+
+  /// Everything watching this observable. Allocated by the first connect() or
+  /// the first computed reading it, and kept from then on: most states in a
+  /// large model are never watched, and pay one pointer for it. A computed
+  /// holds its own.
+  struct observers {
+    signals2::signal2<void(const T&)> sig;
+    detail::dependent_list dependents;
+  };
+
+  /// The block of a computed: also the node get() refreshes through. Only
+  /// computeds pay for the pointer.
+  struct computed_observers : observers {
+    detail::dependency_tracker* node;
+  };
+
+  /// The computed this is the value of. Only when computed_ is set.
+  detail::dependency_tracker* node() const { return static_cast<computed_observers&>(*observers_).node; }
+
+  /// Called by computed's constructors with the block it holds, so get()
+  /// reaches the node without a pointer in every state.
+  void set_block(computed_observers& block) {
+    observers_ = &block;
+    computed_ = true;
+  }
+
+  observers& watchers() const {
+    if (!observers_) {
+      observers_ = new observers();
+    }
+    return *observers_;
+  }
+
+  // Laid out for small T: the block pointer, the revision, the flags, then
+  // the value -- 16 bytes for a state<int>. The flags have a byte of their
+  // own: sharing the revision's word, every set() reloaded the word right
+  // after a byte store to it and stalled on store forwarding.
+  /// Owned unless computed_: then it is the computed's member.
+  mutable observers* observers_ = nullptr;
+  /// Only tells a round that a subscriber set a newer value. Wrapping at
+  /// exactly a multiple of 65536 nested sets merely lets the round finish
+  /// with the newest value before the pending one repeats it.
+  std::uint16_t revision_ = 0;
+  std::uint8_t emitting_ : 1 = 0;
+  std::uint8_t pending_emit_ : 1 = 0;
+  /// Changed inside a batch, listed in detail::deferred_emits.
+  std::uint8_t deferred_ : 1 = 0;
+  /// observers_ is a computed_observers: this is the value of a computed.
+  std::uint8_t computed_ : 1 = 0;
   T value_{};
-  mutable signals2::signal2<void(const T&)> sig_;
-  std::uint64_t revision_ = 0;
-  bool emitting_ = false;
-  bool pending_emit_ = false;
 };
 
 /**
@@ -370,34 +970,50 @@ private:
  * Binding is deferred rather than done in the constructor so that member
  * declaration order inside a model struct does not become load-bearing.
  */
-template <typename T, typename Equal = std::equal_to<>>
+template <typename T, typename Equal = std::equal_to<>, typename Evaluation = eager_evaluation>
   requires std::predicate<Equal&, const T&, const T&> &&
-           std::assignable_from<T&, T>
+           std::assignable_from<T&, T> &&
+           (std::same_as<Evaluation, eager_evaluation> || std::same_as<Evaluation, lazy_evaluation>)
 class computed final : public observable<T>, private detail::dependency_tracker {
 public:
   computed()
     requires std::default_initializable<T> &&
              std::default_initializable<Equal>
-  = default;
+  {
+    this->set_block(block_);
+  }
 
   explicit computed(Equal equal)
     requires std::default_initializable<T>
-      : equal_(std::move(equal)) {}
+      : equal_(std::move(equal)) {
+    this->set_block(block_);
+  }
 
   template <typename... Args>
     requires std::default_initializable<Equal> &&
              std::constructible_from<T, Args...>
   explicit computed(std::in_place_t, Args&&... args)
-      : observable<T>(std::in_place, std::forward<Args>(args)...) {}
+      : observable<T>(std::in_place, std::forward<Args>(args)...) {
+    this->set_block(block_);
+  }
 
   template <typename... Args>
     requires std::constructible_from<T, Args...>
   computed(Equal equal, std::in_place_t, Args&&... args)
       : observable<T>(std::in_place, std::forward<Args>(args)...),
-        equal_(std::move(equal)) {}
+        equal_(std::move(equal)) {
+    this->set_block(block_);
+  }
+
+  ~computed() {
+    if (queued_ != 0) {
+      detail::update_queue::remove(this);
+    }
+  }
 
   /**
-   * @brief set the compute function and evaluate it immediately.
+   * @brief set the compute function and evaluate it immediately -- with
+   *        lazy_evaluation, on the first get() or peek() instead.
    *
    * May be called only once for a computed object. Rebinding would retain
    * subscriptions discovered by the previous compute function.
@@ -410,7 +1026,11 @@ public:
   void bind(F&& calc) {
     assert(!bound() && "signals2::computed::bind() may only be called once");
     calc_ = std::forward<F>(calc);
-    recompute();
+    if constexpr (lazy) {
+      dirty_ = true;
+    } else {
+      recompute();
+    }
   }
 
   bool bound() const { return static_cast<bool>(calc_); }
@@ -422,12 +1042,20 @@ public:
    * when the value also depends on something outside this system -- a resource
    * string that changes on language switch, for instance.
    *
-   * Reentrancy: a dependency may change while this is running -- from inside
-   * calc_ itself, or from a subscriber during emit(). That triggers a nested
-   * recompute(), which is allowed to run: it reads fresher inputs than we did,
-   * so its result supersedes ours. The epoch check below is what makes that
-   * safe -- without it, this frame would unwind and overwrite the nested
-   * (newer) result with a value computed from inputs that no longer hold.
+   * Propagation: a dependency change does not recompute on the spot. It marks
+   * this computed dirty and queues it by height (detail::update_queue); the
+   * queue drains, lowest height first, when the outermost emission returns.
+   * Everything below a computed has settled by the time it runs, so in a
+   * diamond it recomputes once and its subscribers never see a mix of old and
+   * new inputs. A get() or peek() of a dirty computed recomputes it first.
+   *
+   * Reentrancy: a dependency may still change while this is running -- from
+   * inside calc_ itself, or from a subscriber during emit(). Outside a drain
+   * that runs a nested recompute(), which reads fresher inputs than we did, so
+   * its result supersedes ours; inside a drain it queues this computed again.
+   * The check after calc_ covers both -- without it, this frame would unwind
+   * and overwrite the newer result, or publish one computed from inputs that
+   * no longer hold.
    *
    * Nothing here bounds recursion. Feedback that converges terminates on the
    * equality check. See "Cycles" in the file header -- divergent feedback is
@@ -437,9 +1065,11 @@ public:
     if (!calc_) {
       return;
     }
+    SIGNALS2_INSTRUMENT_SPAN(recompute_begin, recompute_end, this);
 
     // Claim an epoch for this pass. Any nested recompute() claims a later one.
     const std::uint64_t started = ++epoch_;
+    dirty_ = false;
 
     // The immediately-invoked lambda ends the tracking scope before the value
     // is stored and subscribers run. Otherwise a subscriber's get() calls would
@@ -449,11 +1079,13 @@ public:
       return static_cast<T>(calc_());
     }();
 
-    if (epoch_ != started) {
-      // A nested pass evaluated fresher inputs underneath us. Our inputs are
-      // stale; committing `next` now would be a lost update. Drop it silently.
+    if (epoch_ != started || dirty_) {
+      // A nested pass evaluated fresher inputs underneath us, or one is queued
+      // to. Our inputs are stale; committing `next` now would be a lost
+      // update. Drop it silently.
       return;
     }
+    release_unread(started);
 
     if (std::invoke(equal_, this->value_, next)) {
       return;
@@ -463,35 +1095,89 @@ public:
   }
 
 private:
-  void on_dependency_changed() override { recompute(); }
+  static constexpr bool lazy = std::same_as<Evaluation, lazy_evaluation>;
 
-  void add_dependency(signals2::connection&& connection) override {
-    deps_.push_back(std::move(connection));
+  void on_dependency_changed(std::uint32_t source_height) override {
+    dirty_ = true;
+    if constexpr (lazy) {
+      // block_ rather than observed(): no load of observers_ to reach it.
+      if (block_.sig.empty() && block_.dependents.empty()) {
+        // Nobody would see the new value; the next read computes it.
+        return;
+      }
+    }
+    raise_height(source_height + 1);
+    if (!scheduled_) {
+      detail::update_queue::push(this);
+    }
   }
 
-  /**
-   * The dependency set only ever grows. When a branch in the compute function
-   * stops reading a state, that subscription is kept rather than dropped, for
-   * two reasons: dropping it would destroy a slot while the signal is still
-   * emitting through it, and a stale dependency only costs one extra recompute,
-   * which the equality check above absorbs. The set is bounded by the number of
-   * states the function can ever reach.
-   */
-  bool try_mark_tracked(const void* dependency) override {
-    if (std::find(tracked_.begin(), tracked_.end(), dependency) != tracked_.end()) {
-      return false;
+  void refresh() override {
+    if (dirty_) {
+      recompute();
     }
-    tracked_.push_back(dependency);
-    return true;
   }
 
+  /// What observable::observers_ points to, with this as its node. First,
+  /// next to observers_: a dependency change reads it to tell whether a
+  /// lazy computed is observed.
+  typename observable<T>::computed_observers block_{ {}, this };
   [[no_unique_address]] Equal equal_{};
   std::function<T()> calc_;
-  std::vector<signals2::connection> deps_;
-  std::vector<const void*> tracked_;
-  std::uint64_t epoch_ = 0;
 };
 
+/**
+ * @brief computed that recomputes only when read, while nothing observes it.
+ *
+ * For values behind hidden views: with no subscriber, a dependency change
+ * costs one flag write, and a value nobody reads is never computed -- not
+ * even on bind(). Once connected, it recomputes eagerly like computed, so
+ * subscribers are notified as usual. Another computed reading it counts as a
+ * subscriber.
+ */
+template <typename T, typename Equal = std::equal_to<>>
+using lazy_computed = computed<T, Equal, lazy_evaluation>;
+
+/**
+ * @brief Defer every notification until the outermost batch on this thread
+ *        ends.
+ *
+ * Inside the scope, set(), mutate() and notify() change values without
+ * notifying. When the outermost batch ends, every observable that changed
+ * notifies once, with its final value, in the order it first changed; the
+ * computeds depending on them then recompute once each.
+ *
+ *   {
+ *     signals2::batch scope;
+ *     model_.name.set(record.name);
+ *     model_.size.set(record.size);   // labels repaint once, at the brace
+ *   }
+ *
+ * Computeds are not updated inside the scope: a get() there still returns
+ * the value from before the batch. An observable changed and changed back
+ * still notifies, with the value it started with.
+ *
+ * The destructor runs subscribers and lets their exceptions through. If the
+ * scope is left by an exception, the deferred notifications are still
+ * delivered, and a subscriber that throws then terminates the program.
+ */
+class batch {
+public:
+  batch() { detail::deferred_emits::open(); }
+  ~batch() noexcept(false) { detail::deferred_emits::close(); }
+
+  batch(const batch&) = delete;
+  batch& operator=(const batch&) = delete;
+};
+
+/// Run @p fn inside a batch and return its result.
+template <typename F>
+  requires std::invocable<F>
+decltype(auto) transaction(F&& fn) {
+  batch scope;
+  return std::invoke(std::forward<F>(fn));
+}
+
 }  // namespace signals2
 
 #endif  // SIGNALS2_STATE_H_
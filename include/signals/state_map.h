@@ -0,0 +1,349 @@
+/**
+ * @file state_map.h
+ * @brief Observable map whose entries are observed one key at a time.
+ *
+ * Built on top of state.h. Header-only. Every key of a state_map<K, V> has an
+ * observable cell of its own: connect(key, fn) and a tracked read such as
+ * at(key) inside a computed wake only on changes to that key. Wrapping a
+ * whole std::unordered_map in a state wakes every reader on every change;
+ * this wakes the readers of the one entry that changed, plus readers of the
+ * key set (size(), for_each()) when a key is inserted or erased.
+ *
+ * Example:
+ *   state_map<UserId, Presence> presence;
+ *   computed<bool> online;
+ *   online.bind([&] { const Presence* p = presence.find(id); return p && p->online; });
+ *   conns_.push_back(presence.connect(id, [this](const Presence* p) { Repaint(p); }));
+ *   presence.set(other_id, away);        // neither `online` nor the slot runs
+ *
+ * Reading a key that is absent inside a compute function tracks it too: the
+ * computed recomputes when the key is inserted. The map keeps an empty cell
+ * for such a key while something observes it, and drops unobserved empty
+ * cells as they accumulate.
+ *
+ * A change to one entry and to the key set is one update: a computed reading
+ * both recomputes once, after both changed. Inside a signals2::batch,
+ * notifications are put off like those of a state.
+ *
+ * Callbacks and the function passed to for_each() must not insert or erase
+ * while for_each() is iterating; connect() is fine. Pointers returned by
+ * find() are valid until that key is erased or set again.
+ *
+ * Threading: not thread-safe, like signals2 itself.
+ */
+
+#ifndef SIGNALS2_STATE_MAP_H_
+#define SIGNALS2_STATE_MAP_H_
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "state.h"
+
+namespace signals2 {
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Equal>
+  requires std::predicate<Equal&, const V&, const V&>
+class state_map;
+
+namespace detail {
+
+/// The observable behind one key of a state_map: the value, or nothing while
+/// the key is absent but observed.
+template <typename V>
+class map_cell final : public observable<std::optional<V>> {
+public:
+  map_cell() = default;
+
+private:
+  template <typename K, typename U, typename Hash, typename KeyEqual, typename Equal>
+    requires std::predicate<Equal&, const U&, const U&>
+  friend class signals2::state_map;
+
+  /// Absent, unobserved and not notifying: nothing would notice it gone.
+  bool droppable() const { return !this->value_ && !this->emitting_ && !this->observed(); }
+};
+
+}  // namespace detail
+
+/**
+ * @brief Writable observable map with per-key dependency tracking.
+ *
+ * Equal compares values: set() of an equal value does nothing. Non-copyable
+ * and non-movable: computeds and connections refer to the cells by address.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>,
+          typename Equal = std::equal_to<>>
+  requires std::predicate<Equal&, const V&, const V&>
+class state_map {
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using size_type = std::size_t;
+
+  state_map() = default;
+
+  state_map(const state_map&) = delete;
+  state_map& operator=(const state_map&) = delete;
+  state_map(state_map&&) = delete;
+  state_map& operator=(state_map&&) = delete;
+
+  /// The value of @p key, or nullptr. Tracked on @p key.
+  const V* find(const K& key) const {
+    const std::optional<V>& value = read(key);
+    return value ? &*value : nullptr;
+  }
+
+  /// The value of @p key; throws std::out_of_range when absent. Tracked on
+  /// @p key either way, so a computed that caught the exception recomputes
+  /// when the key is inserted.
+  const V& at(const K& key) const {
+    const std::optional<V>& value = read(key);
+    if (!value) {
+      throw std::out_of_range("signals2::state_map::at: key not found");
+    }
+    return *value;
+  }
+
+  /// Tracked on @p key.
+  bool contains(const K& key) const { return read(key).has_value(); }
+
+  /// Read without registering a dependency.
+  const V* peek(const K& key) const {
+    const auto it = cells_.find(key);
+    return it != cells_.end() && it->second.value_ ? &*it->second.value_ : nullptr;
+  }
+
+  /// Tracked on the key set: changes with every insert and erase, not with a
+  /// value update.
+  size_type size() const { return size_.get(); }
+  bool empty() const { return size_.get() == 0; }
+
+  /// Call @p fn(key, value) for every entry. Tracked on the key set and on
+  /// every key visited.
+  template <typename F>
+    requires std::invocable<F&, const K&, const V&>
+  void for_each(F&& fn) const {
+    size_.get();
+    ++iterating_;
+    struct iteration_guard {
+      const state_map& map;
+      ~iteration_guard() { map.end_iteration(); }
+    } guard{ *this };
+    for (const auto& [key, cell] : cells_) {
+      // Empty cells are skipped untracked: filling one changes the key set.
+      if (cell.value_) {
+        std::invoke(fn, key, *cell.get());
+      }
+    }
+  }
+
+  /**
+   * @brief Connect a callable taking (const V*) or no arguments, notified
+   *        when the value of @p key changes.
+   *
+   * The pointer is nullptr when the key was erased. The key need not be
+   * present yet. const for the same reason as observable::connect().
+   */
+  template <typename F>
+    requires std::invocable<F, const V*> || std::invocable<F>
+  [[nodiscard]] signals2::connection connect(const K& key, F&& fn) const {
+    cell_type& cell = cell_for(key);
+    if constexpr (std::invocable<F, const V*>) {
+      return cell.connect([f = std::forward<F>(fn)](const std::optional<V>& value) mutable {
+        f(value ? &*value : nullptr);
+      });
+    } else {
+      return cell.connect(std::forward<F>(fn));
+    }
+  }
+
+  /// Insert or assign. Does nothing when Equal considers the value unchanged.
+  void set(const K& key, const V& value)
+    requires std::assignable_from<V&, const V&> && std::constructible_from<V, const V&>
+  {
+    store(key, value);
+  }
+
+  void set(const K& key, V&& value)
+    requires std::assignable_from<V&, V> && std::constructible_from<V, V>
+  {
+    store(key, std::move(value));
+  }
+
+  /// Change the value of @p key in place, then notify unconditionally.
+  /// @return false, doing nothing, when the key is absent.
+  template <typename F>
+    requires std::invocable<F, V&>
+  bool mutate(const K& key, F&& fn) {
+    const auto it = cells_.find(key);
+    if (it == cells_.end() || !it->second.value_) {
+      return false;
+    }
+    cell_type& cell = it->second;
+    std::invoke(std::forward<F>(fn), *cell.value_);
+    publish(&cell, false);
+    return true;
+  }
+
+  /// @return false when the key was absent.
+  bool erase(const K& key) {
+    const auto it = cells_.find(key);
+    if (it == cells_.end() || !it->second.value_) {
+      return false;
+    }
+    cell_type& cell = it->second;
+    if (!cell.emitting_ && !cell.observed()) {
+      cells_.erase(it);
+      publish(nullptr, true);
+      return true;
+    }
+    cell.value_.reset();
+    ++absent_;
+    publish(&cell, true);
+    return true;
+  }
+
+  void clear() {
+    // One batch: the subscribers run after the loop, so none of them can
+    // change the map under it.
+    batch scope;
+    for (auto it = cells_.begin(); it != cells_.end();) {
+      cell_type& cell = it->second;
+      if (!cell.value_) {
+        ++it;
+      } else if (!cell.emitting_ && !cell.observed()) {
+        it = cells_.erase(it);
+      } else {
+        cell.value_.reset();
+        ++absent_;
+        cell.emit();
+        ++it;
+      }
+    }
+    size_.set(0);
+  }
+
+private:
+  using cell_type = detail::map_cell<V>;
+
+  template <typename U>
+  void store(const K& key, U&& value) {
+    cell_type& cell = cell_for(key);
+    if (cell.value_) {
+      if (std::invoke(equal_, *cell.value_, value)) {
+        return;
+      }
+      *cell.value_ = std::forward<U>(value);
+      publish(&cell, false);
+      return;
+    }
+    cell.value_.emplace(std::forward<U>(value));
+    --absent_;
+    publish(&cell, true);
+  }
+
+  /// Notify @p cell and, when the key set changed, the size, as one update.
+  void publish(cell_type* cell, bool resized) {
+    struct emit_scope {
+      ~emit_scope() { detail::update_queue::leave_emit(); }
+    };
+
+    detail::update_queue::enter_emit();
+    {
+      emit_scope scope;
+      if (cell) {
+        cell->emit();
+      }
+      if (resized) {
+        size_.set(cells_.size() - absent_);
+      }
+    }
+    detail::update_queue::flush();
+  }
+
+  const std::optional<V>& read(const K& key) const {
+    const auto it = cells_.find(key);
+    if (it != cells_.end()) {
+      return it->second.get();
+    }
+    if (detail::current_tracker()) {
+      if (iterating_ == 0) {
+        return cell_for(key).get();
+      }
+      // Inserting could rehash under for_each(). Any insert changes the key
+      // set, so tracking that wakes this reader too.
+      size_.get();
+    }
+    return absent_value_;
+  }
+
+  /// The cell of @p key, created empty if there is none.
+  cell_type& cell_for(const K& key) const {
+    const auto it = cells_.find(key);
+    if (it != cells_.end()) {
+      return it->second;
+    }
+    if (iterating_ != 0) {
+      // Inserting into cells_ could rehash, and sweeping erases, under the
+      // running for_each(). Held apart until it ends.
+      const auto [held, inserted] = held_cells_.try_emplace(key);
+      if (inserted) {
+        ++absent_;
+      }
+      return held->second;
+    }
+    if (absent_ >= sweep_at_) {
+      sweep();
+    }
+    ++absent_;
+    return cells_.try_emplace(key).first->second;
+  }
+
+  /// Ends one for_each(); the outermost moves in the cells created during
+  /// it. merge() relinks the nodes, so the cells keep their addresses.
+  void end_iteration() const {
+    if (--iterating_ == 0 && !held_cells_.empty()) {
+      cells_.merge(held_cells_);
+    }
+  }
+
+  /// Drop the empty cells nothing observes any more. Runs when the empty
+  /// cells have doubled since the last sweep, so it is amortized O(1).
+  void sweep() const {
+    for (auto it = cells_.begin(); it != cells_.end();) {
+      if (it->second.droppable()) {
+        it = cells_.erase(it);
+        --absent_;
+      } else {
+        ++it;
+      }
+    }
+    sweep_at_ = 2 * absent_ + min_sweep;
+  }
+
+  static constexpr std::size_t min_sweep = 16;
+  static inline const std::optional<V> absent_value_{};
+
+  // Cells are created by const reads and connects: which keys are observed is
+  // bookkeeping, not the map's value.
+  mutable std::unordered_map<K, cell_type, Hash, KeyEqual> cells_;
+  /// Cells created while for_each() iterates cells_; empty otherwise.
+  mutable std::unordered_map<K, cell_type, Hash, KeyEqual> held_cells_;
+  /// Cells holding no value.
+  mutable std::size_t absent_ = 0;
+  mutable std::size_t sweep_at_ = min_sweep;
+  mutable std::size_t iterating_ = 0;
+  /// Number of entries; notifies on every insert and erase.
+  state<std::size_t> size_{ 0 };
+  [[no_unique_address]] Equal equal_{};
+};
+
+}  // namespace signals2
+
+#endif  // SIGNALS2_STATE_MAP_H_
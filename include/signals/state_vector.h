@@ -0,0 +1,336 @@
+/**
+ * @file state_vector.h
+ * @brief Observable vector that reports what changed, not just that it did.
+ *
+ * Built on top of state.h. Header-only. A state_vector<T> is an
+ * observable<std::vector<T>>: get(), peek(), connect() and dependency
+ * tracking in a computed work exactly as for a state. In addition,
+ * connect_changes() subscribers receive the list of changes since they were
+ * last called -- inserted, removed and updated ranges, moves -- so a list
+ * view updates the affected rows instead of diffing or rebuilding.
+ *
+ * Example:
+ *   state_vector<Row> rows;
+ *   conns_.push_back(rows.connect_changes(
+ *       [this](const std::vector<Row>& all, std::span<const vector_change> changes) {
+ *         for (const vector_change& c : changes) ApplyToListView(all, c);
+ *       }));
+ *   rows.push_back(row);                 // one inserted record
+ *   {
+ *     signals2::batch scope;
+ *     rows.assign(3, a);
+ *     rows.assign(4, b);                 // merged: one updated record for [3, 5)
+ *   }
+ *
+ * Records are applied in order; each one's positions refer to the vector as
+ * it was right after the record before it. Applying them all to the vector a
+ * subscriber last saw gives the vector it is handed. Records appended until
+ * the next notification merge with the previous one when they extend it, so a
+ * batch of push_backs reaches a subscriber as one inserted range.
+ *
+ * The span and the vector reference are valid until the callback changes
+ * this state_vector. Notification is the latest-value notification of
+ * state.h: a subscriber that changes the vector ends the round, and the
+ * subscribers after it receive the earlier records together with the new
+ * ones in the next.
+ *
+ * Threading: not thread-safe, like signals2 itself.
+ */
+
+#ifndef SIGNALS2_STATE_VECTOR_H_
+#define SIGNALS2_STATE_VECTOR_H_
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "state.h"
+
+namespace signals2 {
+
+/// One change to a state_vector.
+struct vector_change {
+  enum class kind : std::uint8_t {
+    /// [index, index + count) are new elements.
+    inserted,
+    /// The count elements starting at index are gone.
+    removed,
+    /// [index, index + count) were assigned or changed in place.
+    updated,
+    /// The element at index is now at to; the ones in between shifted by one.
+    moved,
+    /// Reload the whole vector: after set(), notify(), or for a subscriber
+    /// that missed records because an earlier subscriber threw.
+    reset,
+  };
+
+  kind type;
+  std::size_t index;
+  std::size_t count;
+  /// Destination of a move.
+  std::size_t to;
+
+  bool operator==(const vector_change&) const = default;
+};
+
+namespace detail {
+
+inline constexpr vector_change vector_reset{ vector_change::kind::reset, 0, 0, 0 };
+
+}  // namespace detail
+
+/**
+ * @brief Writable observable vector with change records.
+ *
+ * Equal compares elements: assign() of an equal element and set() of an
+ * equal vector do nothing. Non-copyable and non-movable, like state.
+ */
+template <typename T, typename Equal = std::equal_to<>>
+  requires std::predicate<Equal&, const T&, const T&>
+class state_vector final : public observable<std::vector<T>> {
+public:
+  using vector_type = std::vector<T>;
+  using size_type = std::size_t;
+
+  state_vector()
+    requires std::default_initializable<Equal>
+  = default;
+
+  explicit state_vector(vector_type init)
+    requires std::default_initializable<Equal>
+      : observable<vector_type>(std::move(init)) {}
+
+  state_vector(vector_type init, Equal equal)
+      : observable<vector_type>(std::move(init)), equal_(std::move(equal)) {}
+
+  /**
+   * @brief Connect a callable taking (const std::vector<T>&,
+   *        std::span<const vector_change>).
+   *
+   * The first call lists the changes made after this connect(). const for the
+   * same reason as observable::connect().
+   */
+  template <typename F>
+    requires std::invocable<F&, const vector_type&, std::span<const vector_change>>
+  [[nodiscard]] signals2::connection connect_changes(F&& fn) const {
+    return this->connect([this, f = std::forward<F>(fn), seen = end_sequence()](const vector_type& value) mutable {
+      const std::span<const vector_change> changes = changes_since(seen);
+      seen = end_sequence();
+      // Delivered: later records must not be merged into these.
+      sealed_ = log_.size();
+      std::invoke(f, value, changes);
+    });
+  }
+
+  /// Tracked reads, shorthand for get().size(), get().empty() and get()[index].
+  size_type size() const { return this->get().size(); }
+  bool empty() const { return this->get().empty(); }
+  const T& operator[](size_type index) const { return this->get()[index]; }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+    requires std::constructible_from<T, Args...>
+  void emplace_back(Args&&... args) {
+    this->value_.emplace_back(std::forward<Args>(args)...);
+    changed(vector_change::kind::inserted, this->value_.size() - 1, 1);
+  }
+
+  void insert(size_type index, const T& value) {
+    assert(index <= this->value_.size());
+    this->value_.insert(this->value_.begin() + static_cast<std::ptrdiff_t>(index), value);
+    changed(vector_change::kind::inserted, index, 1);
+  }
+
+  void insert(size_type index, T&& value) {
+    assert(index <= this->value_.size());
+    this->value_.insert(this->value_.begin() + static_cast<std::ptrdiff_t>(index), std::move(value));
+    changed(vector_change::kind::inserted, index, 1);
+  }
+
+  /// Insert [first, last) before @p index; one inserted record.
+  template <std::forward_iterator It>
+  void insert(size_type index, It first, It last) {
+    assert(index <= this->value_.size());
+    const size_type count = static_cast<size_type>(std::distance(first, last));
+    if (count == 0) {
+      return;
+    }
+    this->value_.insert(this->value_.begin() + static_cast<std::ptrdiff_t>(index), first, last);
+    changed(vector_change::kind::inserted, index, count);
+  }
+
+  /// Remove @p count elements starting at @p index.
+  void erase(size_type index, size_type count = 1) {
+    assert(index + count <= this->value_.size());
+    if (count == 0) {
+      return;
+    }
+    const auto first = this->value_.begin() + static_cast<std::ptrdiff_t>(index);
+    this->value_.erase(first, first + static_cast<std::ptrdiff_t>(count));
+    changed(vector_change::kind::removed, index, count);
+  }
+
+  void clear() {
+    if (!this->value_.empty()) {
+      erase(0, this->value_.size());
+    }
+  }
+
+  /// Replace the element at @p index; does nothing when Equal considers it
+  /// unchanged.
+  void assign(size_type index, const T& value) {
+    assert(index < this->value_.size());
+    if (std::invoke(equal_, this->value_[index], value)) {
+      return;
+    }
+    this->value_[index] = value;
+    changed(vector_change::kind::updated, index, 1);
+  }
+
+  void assign(size_type index, T&& value) {
+    assert(index < this->value_.size());
+    if (std::invoke(equal_, this->value_[index], value)) {
+      return;
+    }
+    this->value_[index] = std::move(value);
+    changed(vector_change::kind::updated, index, 1);
+  }
+
+  /// Change the element at @p index in place, then notify unconditionally.
+  template <typename F>
+    requires std::invocable<F, T&>
+  void mutate(size_type index, F&& fn) {
+    assert(index < this->value_.size());
+    std::invoke(std::forward<F>(fn), this->value_[index]);
+    changed(vector_change::kind::updated, index, 1);
+  }
+
+  /// Move the element at @p from so that it ends up at @p to.
+  void move(size_type from, size_type to) {
+    assert(from < this->value_.size() && to < this->value_.size());
+    if (from == to) {
+      return;
+    }
+    const auto begin = this->value_.begin();
+    if (from < to) {
+      std::rotate(begin + static_cast<std::ptrdiff_t>(from), begin + static_cast<std::ptrdiff_t>(from + 1),
+                  begin + static_cast<std::ptrdiff_t>(to + 1));
+    } else {
+      std::rotate(begin + static_cast<std::ptrdiff_t>(to), begin + static_cast<std::ptrdiff_t>(from),
+                  begin + static_cast<std::ptrdiff_t>(from + 1));
+    }
+    changed(vector_change::kind::moved, from, 1, to);
+  }
+
+  /// Replace the whole vector; a reset record. Does nothing when every
+  /// element compares equal.
+  void set(vector_type value) {
+    if (std::ranges::equal(this->value_, value, std::ref(equal_))) {
+      return;
+    }
+    this->value_ = std::move(value);
+    changed(vector_change::kind::reset, 0, 0);
+  }
+
+private:
+  void changed(vector_change::kind type, size_type index, size_type count, size_type to = 0) {
+    record(vector_change{ type, index, count, to });
+    this->emit();
+  }
+
+  void record(const vector_change& change) {
+    if (!this->emitting_ && !this->deferred_) {
+      // No notification is running or put off, so every subscriber has had
+      // the log. One an exception skipped gets a reset instead.
+      base_ += log_.size();
+      log_.clear();
+      sealed_ = 0;
+    }
+    // Records only serve subscribers; an unsubscribed vector keeps none.
+    if (!this->observers_ || this->observers_->sig.empty()) {
+      return;
+    }
+    if (change.type == vector_change::kind::reset) {
+      // Supersedes everything nobody has read yet.
+      log_.resize(sealed_);
+    } else if (log_.size() > sealed_ && merge(log_.back(), change)) {
+      return;
+    }
+    log_.push_back(change);
+  }
+
+  /// Fold @p next into @p last when the two read as one record.
+  static bool merge(vector_change& last, const vector_change& next) {
+    using kind = vector_change::kind;
+    if (last.type == kind::reset) {
+      return true;
+    }
+    if (last.type == kind::inserted && next.type == kind::inserted &&
+        next.index >= last.index && next.index <= last.index + last.count) {
+      last.count += next.count;
+      return true;
+    }
+    if (last.type == kind::inserted && next.type == kind::updated &&
+        next.index >= last.index && next.index + next.count <= last.index + last.count) {
+      return true;
+    }
+    if (last.type == kind::removed && next.type == kind::removed) {
+      if (next.index == last.index) {
+        last.count += next.count;
+        return true;
+      }
+      if (next.index + next.count == last.index) {
+        last.index = next.index;
+        last.count += next.count;
+        return true;
+      }
+    }
+    if (last.type == kind::updated && next.type == kind::updated &&
+        next.index <= last.index + last.count && last.index <= next.index + next.count) {
+      const size_type end = std::max(last.index + last.count, next.index + next.count);
+      last.index = std::min(last.index, next.index);
+      last.count = end - last.index;
+      return true;
+    }
+    return false;
+  }
+
+  std::uint64_t end_sequence() const { return base_ + log_.size(); }
+
+  std::span<const vector_change> changes_since(std::uint64_t seen) const {
+    if (seen < base_ || seen == end_sequence()) {
+      // Trimmed past it, or notify() without a change.
+      return std::span<const vector_change>(&detail::vector_reset, 1);
+    }
+    const std::span<const vector_change> changes =
+        std::span<const vector_change>(log_).subspan(static_cast<std::size_t>(seen - base_));
+    // A reset sealed by an earlier subscriber can have records after it. The
+    // reload already shows their effect, so replaying them would apply them
+    // twice.
+    if (std::ranges::any_of(changes, [](const vector_change& c) { return c.type == vector_change::kind::reset; })) {
+      return std::span<const vector_change>(&detail::vector_reset, 1);
+    }
+    return changes;
+  }
+
+  /// Records not yet delivered to every subscriber; record k has sequence
+  /// number base_ + k.
+  std::vector<vector_change> log_;
+  std::uint64_t base_ = 0;
+  /// Records before this index have been delivered and must stay as they are.
+  mutable std::size_t sealed_ = 0;
+  [[no_unique_address]] Equal equal_{};
+};
+
+}  // namespace signals2
+
+#endif  // SIGNALS2_STATE_VECTOR_H_
@@ -0,0 +1,356 @@
+/**
+ * @file trace.h
+ * @brief Chrome trace-event export of signal emissions and state propagation.
+ *
+ * Requires SIGNALS2_INSTRUMENT (see instrument.h). trace::start() installs
+ * instrumentation hooks that record one span per signal emission,
+ * observable::emit() notification and computed::recompute() pass into a
+ * per-thread ring buffer. trace::write_chrome_json() writes everything
+ * recorded so far as trace-event JSON, loadable in chrome://tracing or
+ * ui.perfetto.dev.
+ *
+ * Example, one UI frame:
+ *   signals2::trace::start();
+ *   RunFrame();
+ *   signals2::trace::stop();
+ *   std::ofstream out("frame.json");
+ *   signals2::trace::write_chrome_json(out);
+ *
+ * Signal spans are labelled with the name given to signal_impl::set_name(),
+ * and carry the number of slots; observable and computed spans carry the
+ * object address.
+ *
+ * Recording takes no lock: each thread appends to its own ring buffer, and
+ * when the buffer is full the oldest events are overwritten. Timestamps come
+ * from the time-stamp counter where available and are converted to
+ * nanoseconds when written. Spans nested deeper than max_depth are not
+ * recorded.
+ *
+ * Threading: write_chrome_json() and clear() must not run while another
+ * thread is recording; call them after stop(), or from the only thread that
+ * emits, as in the example.
+ */
+
+#ifndef SIGNALS2_TRACE_H_
+#define SIGNALS2_TRACE_H_
+
+#include "signals.h"
+
+#if !defined(SIGNALS2_INSTRUMENT)
+#error "signals/trace.h requires SIGNALS2_INSTRUMENT"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SIGNALS2_TRACE_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define SIGNALS2_TRACE_RDTSC 1
+#endif
+
+namespace signals2 {
+namespace trace {
+
+enum class span_kind : std::uint8_t {
+  signal,
+  observable,
+  recompute,
+};
+
+struct event {
+  const void* object;
+  const char* name;
+  std::uint64_t begin;
+  std::uint64_t end;
+  std::uint32_t slots;
+  span_kind kind;
+};
+
+inline constexpr std::size_t max_depth = 64;
+
+namespace detail {
+
+inline std::uint64_t ticks() {
+#if defined(SIGNALS2_TRACE_RDTSC)
+  return __rdtsc();
+#else
+  return instrument::now();
+#endif
+}
+
+/// Counts start() calls. A thread buffer tells by it that spans it still
+/// has open were left open by stop().
+inline std::atomic<std::uint32_t> session_round{ 0 };
+
+class thread_buffer {
+public:
+  // Capacity is rounded up to a power of two so the ring index is a mask.
+  thread_buffer(std::size_t capacity, std::uint32_t thread_id)
+      : events_(round_up(capacity)), mask_(events_.size() - 1),
+        round_(session_round.load(std::memory_order_relaxed)), thread_id_(thread_id) {}
+
+  void begin(span_kind kind, const void* object, const char* name, std::uint32_t slots) {
+    same_round();
+    if (depth_ < max_depth) {
+      open_[depth_] = event{ object, name, ticks(), 0, slots, kind };
+    }
+    ++depth_;
+  }
+
+  void end() {
+    if (!same_round() || depth_ == 0) {
+      return;  // started before trace::start()
+    }
+    --depth_;
+    if (depth_ >= max_depth) {
+      return;
+    }
+    event& e = open_[depth_];
+    e.end = ticks();
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    events_[head & mask_] = e;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  template <typename Visitor>
+  void for_each(Visitor&& visit) const {
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    const std::uint64_t count = head < events_.size() ? head : events_.size();
+    for (std::uint64_t i = head - count; i != head; ++i) {
+      visit(events_[i & mask_]);
+    }
+  }
+
+  void clear() { head_.store(0, std::memory_order_release); }
+
+  std::uint32_t thread_id() const { return thread_id_; }
+
+private:
+  /// Drops the spans an earlier round left open, so the nesting depth counts
+  /// from this round's start(). @return false when it dropped them.
+  bool same_round() {
+    const std::uint32_t current = session_round.load(std::memory_order_relaxed);
+    if (round_ == current) {
+      return true;
+    }
+    round_ = current;
+    depth_ = 0;
+    return false;
+  }
+
+  static std::size_t round_up(std::size_t capacity) {
+    std::size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  std::vector<event> events_;
+  std::uint64_t mask_;
+  std::atomic<std::uint64_t> head_{ 0 };
+  event open_[max_depth];
+  std::size_t depth_ = 0;
+  std::uint32_t round_;
+  std::uint32_t thread_id_;
+};
+
+struct session {
+  std::mutex mutex;
+  // shared_ptr: a thread's events stay readable after the thread exits.
+  std::vector<std::shared_ptr<thread_buffer>> buffers;
+  std::size_t capacity = 0;
+  std::uint64_t start_ticks = 0;
+  std::uint64_t start_ns = 0;
+  instrument::hooks previous_hooks;
+  /// Between start() and stop(): previous_hooks holds what stop() restores.
+  bool recording = false;
+};
+
+inline session& current_session() {
+  static session s;
+  return s;
+}
+
+/// This thread's ring buffer, created on its first event. nullptr before
+/// start() has set the capacity: a hook still running on another thread
+/// after stop() records nothing.
+inline thread_buffer* local_buffer() {
+  thread_local thread_buffer* buffer = nullptr;
+  if (!buffer) {
+    session& s = current_session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.recording) {
+      return nullptr;
+    }
+    s.buffers.push_back(std::make_shared<thread_buffer>(
+        s.capacity, static_cast<std::uint32_t>(s.buffers.size() + 1)));
+    buffer = s.buffers.back().get();
+  }
+  return buffer;
+}
+
+inline void begin_span(span_kind kind, const void* object, const char* name, std::uint32_t slots) {
+  if (thread_buffer* buffer = local_buffer()) {
+    buffer->begin(kind, object, name, slots);
+  }
+}
+
+inline void end_span() {
+  if (thread_buffer* buffer = local_buffer()) {
+    buffer->end();
+  }
+}
+
+inline void write_json_string(std::ostream& out, const char* text) {
+  out << '"';
+  for (; *text; ++text) {
+    const unsigned char c = static_cast<unsigned char>(*text);
+    if (c == '"' || c == '\\') {
+      out << '\\' << *text;
+    } else if (c < 0x20) {
+      static const char digits[] = "0123456789abcdef";
+      out << "\\u00" << digits[c >> 4] << digits[c & 0xf];
+    } else {
+      out << *text;
+    }
+  }
+  out << '"';
+}
+
+}  // namespace detail
+
+/**
+ * @brief Install the trace hooks and start recording.
+ *
+ * @param events_per_thread ring buffer size of each recording thread. Takes
+ *        effect for threads that record their first event after this call.
+ *
+ * Replaces the installed instrumentation hooks; stop() restores them. Does
+ * nothing while already recording: the hooks to restore are the ones from
+ * before the first start().
+ */
+inline void start(std::size_t events_per_thread = std::size_t(1) << 16) {
+  detail::session& s = detail::current_session();
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.recording) {
+      return;
+    }
+    s.recording = true;
+    s.capacity = events_per_thread;
+    detail::session_round.fetch_add(1, std::memory_order_relaxed);
+    // Timestamps are relative to the first start(), so events recorded by
+    // earlier start()/stop() rounds keep their place on the timeline.
+    if (s.start_ns == 0) {
+      s.start_ticks = detail::ticks();
+      s.start_ns = instrument::now();
+    }
+    s.previous_hooks = instrument::installed_hooks;
+  }
+
+  instrument::hooks h;
+  h.emit_begin = [](const instrument::signal_stats& signal, std::size_t slots) {
+    detail::begin_span(span_kind::signal, &signal, signal.name, static_cast<std::uint32_t>(slots));
+  };
+  h.emit_end = [](const instrument::signal_stats*) { detail::end_span(); };
+  h.observable_emit_begin = [](const void* observable) {
+    detail::begin_span(span_kind::observable, observable, nullptr, 0);
+  };
+  h.observable_emit_end = [](const void*) { detail::end_span(); };
+  h.recompute_begin = [](const void* computed) {
+    detail::begin_span(span_kind::recompute, computed, nullptr, 0);
+  };
+  h.recompute_end = [](const void*) { detail::end_span(); };
+  instrument::install(h);
+}
+
+/// Stop recording and restore the hooks installed before start(). Does
+/// nothing when not recording.
+inline void stop() {
+  detail::session& s = detail::current_session();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (!s.recording) {
+    return;
+  }
+  s.recording = false;
+  instrument::install(s.previous_hooks);
+}
+
+/// Drop every recorded event.
+inline void clear() {
+  detail::session& s = detail::current_session();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  for (const std::shared_ptr<detail::thread_buffer>& buffer : s.buffers) {
+    buffer->clear();
+  }
+}
+
+/// Write the recorded events as a Chrome trace-event JSON document.
+inline void write_chrome_json(std::ostream& out) {
+  detail::session& s = detail::current_session();
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  // Calibrate ticks against the steady clock over the whole session.
+  const std::uint64_t elapsed_ticks = detail::ticks() - s.start_ticks;
+  const std::uint64_t elapsed_ns = instrument::now() - s.start_ns;
+  const double ns_per_tick = elapsed_ticks == 0 ? 1.0 : static_cast<double>(elapsed_ns) / static_cast<double>(elapsed_ticks);
+  const auto to_us = [&](std::uint64_t t) {
+    return static_cast<double>(static_cast<std::int64_t>(t - s.start_ticks)) * ns_per_tick / 1000.0;
+  };
+
+  // Microseconds to the nanosecond. The default six significant digits
+  // round anything a second into the session to 10us or coarser.
+  const std::ios_base::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3);
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (const std::shared_ptr<detail::thread_buffer>& buffer : s.buffers) {
+    buffer->for_each([&](const event& e) {
+      if (!first) {
+        out << ',';
+      }
+      first = false;
+      out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id() << ",\"name\":";
+      switch (e.kind) {
+        case span_kind::signal:
+          detail::write_json_string(out, e.name ? e.name : "signal");
+          out << ",\"cat\":\"signal\"";
+          break;
+        case span_kind::observable:
+          out << "\"observable::emit\",\"cat\":\"state\"";
+          break;
+        case span_kind::recompute:
+          out << "\"computed::recompute\",\"cat\":\"state\"";
+          break;
+      }
+      out << ",\"ts\":" << to_us(e.begin) << ",\"dur\":" << static_cast<double>(e.end - e.begin) * ns_per_tick / 1000.0
+          << ",\"args\":{\"object\":\"" << e.object << '"';
+      if (e.kind == span_kind::signal) {
+        out << ",\"slots\":" << e.slots;
+      }
+      out << "}}";
+    });
+  }
+  out << "]}";
+  out.flags(flags);
+  out.precision(precision);
+}
+
+}  // namespace trace
+}  // namespace signals2
+
+#endif  // SIGNALS2_TRACE_H_
@@ -0,0 +1,166 @@
+/**
+ * Counting replacements of the global allocation functions.
+ *
+ * The replacements live in the same translation unit as current(), so any
+ * program that reads the counters also pulls them out of the static library.
+ */
+
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{ 0 };
+std::atomic<std::uint64_t> deallocations{ 0 };
+std::atomic<std::uint64_t> bytes{ 0 };
+std::atomic<std::uint64_t> usable_bytes{ 0 };
+std::atomic<std::int64_t> live_bytes{ 0 };
+std::atomic<std::int64_t> peak_bytes{ 0 };
+
+std::size_t usable_size(void* p, std::size_t alignment) {
+#if defined(_MSC_VER)
+  return alignment == 0 ? _msize(p) : _aligned_msize(p, alignment, 0);
+#elif defined(__APPLE__)
+  (void)alignment;
+  return malloc_size(p);
+#else
+  (void)alignment;
+  return malloc_usable_size(p);
+#endif
+}
+
+void* count_alloc(void* p, std::size_t size, std::size_t alignment) {
+  if (!p) {
+    return p;
+  }
+  const std::size_t usable = usable_size(p, alignment);
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  bytes.fetch_add(size, std::memory_order_relaxed);
+  usable_bytes.fetch_add(usable, std::memory_order_relaxed);
+  const std::int64_t live =
+      live_bytes.fetch_add(static_cast<std::int64_t>(usable), std::memory_order_relaxed) + static_cast<std::int64_t>(usable);
+  std::int64_t peak = peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+  return p;
+}
+
+void count_free(void* p, std::size_t alignment) {
+  deallocations.fetch_add(1, std::memory_order_relaxed);
+  live_bytes.fetch_sub(static_cast<std::int64_t>(usable_size(p, alignment)), std::memory_order_relaxed);
+}
+
+void* counted_alloc(std::size_t size) {
+  return count_alloc(std::malloc(size == 0 ? 1 : size), size, 0);
+}
+
+void* counted_aligned_alloc(std::size_t size, std::align_val_t alignment) {
+  const std::size_t align = static_cast<std::size_t>(alignment);
+#if defined(_MSC_VER)
+  return count_alloc(_aligned_malloc(size == 0 ? 1 : size, align), size, align);
+#else
+  // aligned_alloc wants a size that is a multiple of the alignment.
+  const std::size_t rounded = (size + align - 1) / align * align;
+  return count_alloc(std::aligned_alloc(align, rounded == 0 ? align : rounded), size, align);
+#endif
+}
+
+void counted_free(void* p) {
+  if (p) {
+    count_free(p, 0);
+    std::free(p);
+  }
+}
+
+void counted_aligned_free(void* p, std::align_val_t alignment) {
+  if (p) {
+    count_free(p, static_cast<std::size_t>(alignment));
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+  }
+}
+
+}  // namespace
+
+namespace alloc_counter {
+
+snapshot current() {
+  return snapshot{ allocations.load(std::memory_order_relaxed),
+                   deallocations.load(std::memory_order_relaxed),
+                   bytes.load(std::memory_order_relaxed),
+                   usable_bytes.load(std::memory_order_relaxed),
+                   live_bytes.load(std::memory_order_relaxed),
+                   peak_bytes.load(std::memory_order_relaxed) };
+}
+
+void reset_peak() {
+  peak_bytes.store(live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+}  // namespace alloc_counter
+
+void* operator new(std::size_t size) {
+  if (void* p = counted_alloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return counted_alloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  if (void* p = counted_aligned_alloc(size, alignment)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return counted_aligned_alloc(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return counted_aligned_alloc(size, alignment);
+}
+
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { counted_aligned_free(p, alignment); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { counted_aligned_free(p, alignment); }
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept { counted_aligned_free(p, alignment); }
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept { counted_aligned_free(p, alignment); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { counted_aligned_free(p, alignment); }
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { counted_aligned_free(p, alignment); }
@@ -0,0 +1,50 @@
+/**
+ * Global allocation counters for benchmarks and tests.
+ *
+ * Linking the signals2_alloc_counter library replaces the global operator new
+ * and operator delete of the whole program with versions that count every
+ * allocation. The counters are process-wide and relaxed-atomic: read them
+ * around single-threaded code, or accept that other threads contribute.
+ *
+ * bytes is what the program asked for. live_bytes and peak_bytes are measured
+ * in the allocator's usable size (malloc_usable_size, _msize, malloc_size), so
+ * they include the size-class rounding that requested sizes hide.
+ */
+
+#ifndef SIGNALS2_TEST_ALLOC_COUNTER_H_
+#define SIGNALS2_TEST_ALLOC_COUNTER_H_
+
+#include <cstdint>
+
+namespace alloc_counter {
+
+struct snapshot {
+  std::uint64_t allocations = 0;
+  std::uint64_t deallocations = 0;
+  std::uint64_t bytes = 0;
+  std::uint64_t usable_bytes = 0;
+  /// Not differences: current and highest usable bytes allocated and not freed.
+  std::int64_t live_bytes = 0;
+  std::int64_t peak_bytes = 0;
+};
+
+/// Totals since program start.
+snapshot current();
+
+/// Restart peak tracking from the current live bytes.
+void reset_peak();
+
+/// Difference of the cumulative counters of two snapshots, @p later minus
+/// @p earlier. live_bytes and peak_bytes are taken from @p later.
+inline snapshot operator-(const snapshot& later, const snapshot& earlier) {
+  return snapshot{ later.allocations - earlier.allocations,
+                   later.deallocations - earlier.deallocations,
+                   later.bytes - earlier.bytes,
+                   later.usable_bytes - earlier.usable_bytes,
+                   later.live_bytes,
+                   later.peak_bytes };
+}
+
+}  // namespace alloc_counter
+
+#endif  // SIGNALS2_TEST_ALLOC_COUNTER_H_
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""Compare benchmark runs against a checked-in baseline.
+
+Runs each benchmark executable with repetitions and JSON output, then for
+every benchmark present in both the run and the baseline:
+  - compares the median CPU time,
+  - tests the two sets of repetitions with a two-sided Mann-Whitney U test,
+  - reports a regression or improvement when the change is both larger than
+    --threshold and significant at --alpha.
+It also prints signals2 against boost for the benchmarks that exist in both
+flavours, so a release can state both deltas.
+
+Exits with status 1 when any regression is found.
+
+    bench_compare.py --baseline test/benchmark_baseline.json \\
+        --benchmark build/test/signals_benchmark \\
+        --benchmark build/test/state_benchmark
+
+--update rewrites the baseline from the new run instead of comparing. A
+baseline only means something on the machine it was recorded on: regenerate
+it there (build target signals2_bench_baseline) before comparing a change.
+
+Standard library only; no scipy.
+"""
+
+import argparse
+import json
+import math
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+TIME_UNITS_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def run_benchmark(executable, benchmark_filter, repetitions, min_time):
+    """Return {name: [cpu time in ns per repetition]} for one executable."""
+    fd, out_path = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+    try:
+        command = [
+            executable,
+            "--benchmark_repetitions=%d" % repetitions,
+            "--benchmark_out=%s" % out_path,
+            "--benchmark_out_format=json",
+            "--benchmark_min_time=%s" % min_time,
+            # Spread the repetitions of each benchmark over the whole run, so
+            # a slow phase of the machine does not land on one benchmark only.
+            "--benchmark_enable_random_interleaving=true",
+        ]
+        if benchmark_filter:
+            command.append("--benchmark_filter=%s" % benchmark_filter)
+        subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+        with open(out_path) as f:
+            report = json.load(f)
+    finally:
+        os.remove(out_path)
+
+    samples = {}
+    for entry in report.get("benchmarks", []):
+        if entry.get("run_type", "iteration") != "iteration" or entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        scale = TIME_UNITS_NS[entry.get("time_unit", "ns")]
+        samples.setdefault(name, []).append(entry["cpu_time"] * scale)
+    return samples
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test, normal approximation with
+    tie and continuity correction."""
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    combined = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(combined)
+    tie_term = 0.0
+    i = 0
+    while i < len(combined):
+        j = i
+        while j + 1 < len(combined) and combined[j + 1][0] == combined[i][0]:
+            j += 1
+        rank = (i + j) / 2.0 + 1.0
+        for k in range(i, j + 1):
+            ranks[k] = rank
+        ties = j - i + 1
+        tie_term += ties ** 3 - ties
+        i = j + 1
+    rank_sum_a = sum(r for r, (_, group) in zip(ranks, combined) if group == 0)
+    u = rank_sum_a - n1 * (n1 + 1) / 2.0
+    n = n1 + n2
+    mean = n1 * n2 / 2.0
+    variance = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u - mean) - 0.5) / math.sqrt(variance)
+    return max(0.0, min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2.0))))
+
+
+def boost_counterpart(name):
+    """Name of the boost flavour of a signals2 benchmark, or None."""
+    if "SignalsSignal, SignalsConnection" in name:
+        return name.replace("SignalsSignal, SignalsConnection", "BoostSignal, BoostConnection")
+    if "BenchMarkSignal" in name:
+        return name.replace("BenchMarkSignal", "BenchMarkBoost", 1)
+    return None
+
+
+def format_ns(value):
+    if value >= 1e6:
+        return "%.2f ms" % (value / 1e6)
+    if value >= 1e3:
+        return "%.2f us" % (value / 1e3)
+    return "%.2f ns" % value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--baseline", required=True, help="baseline JSON file")
+    parser.add_argument("--benchmark", action="append", required=True,
+                        help="benchmark executable; may be repeated")
+    parser.add_argument("--filter", default="", help="--benchmark_filter passed to every executable")
+    parser.add_argument("--repetitions", type=int, default=10)
+    parser.add_argument("--min-time", default="0.05", help="--benchmark_min_time, in seconds")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative change of the median to report (default 0.05)")
+    parser.add_argument("--alpha", type=float, default=0.05, help="significance level (default 0.05)")
+    parser.add_argument("--update", action="store_true", help="rewrite the baseline from this run")
+    args = parser.parse_args()
+
+    current = {}
+    for executable in args.benchmark:
+        prefix = os.path.splitext(os.path.basename(executable))[0]
+        print("running %s ..." % prefix, file=sys.stderr)
+        for name, times in run_benchmark(executable, args.filter, args.repetitions, args.min_time).items():
+            current["%s:%s" % (prefix, name)] = times
+
+    if args.update:
+        with open(args.baseline, "w") as f:
+            json.dump({"unit": "ns", "metric": "cpu_time", "benchmarks": current}, f, indent=1, sort_keys=True)
+            f.write("\n")
+        print("wrote %d benchmarks to %s" % (len(current), args.baseline))
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)["benchmarks"]
+
+    regressions, improvements, unchanged = [], [], []
+    for name in sorted(current):
+        if name not in baseline:
+            continue
+        old, new = baseline[name], current[name]
+        old_median, new_median = statistics.median(old), statistics.median(new)
+        change = new_median / old_median - 1.0 if old_median > 0 else 0.0
+        p = mann_whitney_p(old, new)
+        row = (name, old_median, new_median, change, p)
+        if p < args.alpha and change > args.threshold:
+            regressions.append(row)
+        elif p < args.alpha and change < -args.threshold:
+            improvements.append(row)
+        else:
+            unchanged.append(row)
+
+    def print_rows(title, rows):
+        if not rows:
+            return
+        print("\n%s (%d)" % (title, len(rows)))
+        width = max(len(row[0]) for row in rows)
+        for name, old_median, new_median, change, p in rows:
+            print("  %-*s %12s -> %12s  %+7.1f%%  p=%.3f"
+                  % (width, name, format_ns(old_median), format_ns(new_median), change * 100.0, p))
+
+    print("median CPU time vs %s; threshold %.0f%%, alpha %.2f, %d repetitions"
+          % (args.baseline, args.threshold * 100.0, args.alpha, args.repetitions))
+    print_rows("REGRESSIONS", regressions)
+    print_rows("IMPROVEMENTS", improvements)
+    print_rows("unchanged", unchanged)
+
+    missing = sorted(set(current) - set(baseline))
+    if missing:
+        print("\nnot in baseline: %s" % ", ".join(missing))
+
+    pairs = []
+    for name in sorted(current):
+        other = boost_counterpart(name)
+        if other and other in current:
+            pairs.append((name, statistics.median(current[name]), statistics.median(current[other])))
+    if pairs:
+        print("\nsignals2 vs boost (this run)")
+        width = max(len(pair[0]) for pair in pairs)
+        for name, ours, theirs in pairs:
+            print("  %-*s %12s vs %12s  %6.2fx" % (width, name, format_ns(ours), format_ns(theirs), theirs / ours))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,70 @@
+/**
+ * Reports what a benchmark loop did besides taking time, as Google Benchmark
+ * user counters.
+ *
+ * Declare a bench_probe right before the timed loop; when it goes out of
+ * scope it publishes, per iteration of that run:
+ *   - allocs_per_iter and bytes_per_iter, always (see alloc_counter.h);
+ *   - cycles_per_iter, instructions_per_iter, l1d_misses_per_iter,
+ *     llc_misses_per_iter and branch_misses_per_iter, when
+ *     SIGNALS2_PERF_COUNTERS is set and the kernel allows it (see
+ *     perf_counters.h).
+ * Setup done under PauseTiming() inside the loop is counted too, so only
+ * probe loops that do not pause.
+ *
+ *   void BenchMarkSomething(benchmark::State& state) {
+ *     ... setup ...
+ *     bench_probe probe(state);
+ *     for (auto _ : state) { ... }
+ *   }
+ *
+ * Requires linking signals2_alloc_counter and signals2_perf_counters.
+ */
+
+#ifndef SIGNALS2_TEST_BENCH_PROBE_H_
+#define SIGNALS2_TEST_BENCH_PROBE_H_
+
+#include <cstddef>
+#include <string>
+
+#include "alloc_counter.h"
+#include "perf_counters.h"
+#include "benchmark/benchmark.h"
+
+class bench_probe {
+public:
+  // Hardware counters start last and stop first, so they see only the loop.
+  explicit bench_probe(benchmark::State& state)
+      : state_(state), allocs_(alloc_counter::current()), perf_(perf_counters::available()) {
+    if (perf_) {
+      perf_counters::start();
+    }
+  }
+
+  ~bench_probe() {
+    if (perf_) {
+      const perf_counters::sample sample = perf_counters::stop();
+      for (std::size_t i = 0; i < perf_counters::event_count; ++i) {
+        if (sample.valid[i]) {
+          state_.counters[std::string(perf_counters::name(i)) + "_per_iter"] =
+              benchmark::Counter(static_cast<double>(sample.values[i]), benchmark::Counter::kAvgIterations);
+        }
+      }
+    }
+    const alloc_counter::snapshot used = alloc_counter::current() - allocs_;
+    state_.counters["allocs_per_iter"] =
+        benchmark::Counter(static_cast<double>(used.allocations), benchmark::Counter::kAvgIterations);
+    state_.counters["bytes_per_iter"] =
+        benchmark::Counter(static_cast<double>(used.bytes), benchmark::Counter::kAvgIterations);
+  }
+
+  bench_probe(const bench_probe&) = delete;
+  bench_probe& operator=(const bench_probe&) = delete;
+
+private:
+  benchmark::State& state_;
+  alloc_counter::snapshot allocs_;
+  bool perf_;
+};
+
+#endif  // SIGNALS2_TEST_BENCH_PROBE_H_
@@ -0,0 +1,233 @@
+/**
+ * Multi-threaded contention: signals2::signal2 behind one std::mutex against
+ * boost::signals2's internally locked signal.
+ *
+ * signals2 is single-threaded by design; the mutex wrapper is what a caller
+ * has to write today, and the baseline a future concurrent policy must beat.
+ *
+ * One benchmark iteration is a round: E emitter threads share a fixed total of
+ * emissions while C churn threads connect and disconnect a slot as fast as
+ * they can. The round is timed from the moment every thread is released until
+ * the last emitter finishes; thread start-up is not included (manual time).
+ * Every emission is timed on its own and recorded in a histogram, reported as
+ * p50/p99/p999 latency in nanoseconds. The clock read is part of each
+ * recorded latency, and with more threads than cores the tail is dominated by
+ * preemption -- compare the two libraries at equal settings, not against the
+ * single-threaded benchmarks.
+ */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <signals/signals.h>
+#include "boost/signals2.hpp"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+constexpr int64_t kEmitsPerRound = int64_t(1) << 15;
+constexpr int kFixedSlots = 4;
+
+void ContentionSlot(int& i) {
+  ++i;
+}
+
+std::uint64_t NowNanoseconds() {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Log-linear histogram: four buckets per power of two, so a percentile is
+/// exact to within 25%.
+class LatencyHistogram {
+public:
+  void Record(std::uint64_t ns) { ++buckets_[Index(ns)]; }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+  }
+
+  /// Upper bound of the bucket holding the @p q quantile.
+  std::uint64_t Percentile(double q) const {
+    std::uint64_t total = 0;
+    for (std::uint64_t count : buckets_) {
+      total += count;
+    }
+    const std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(total));
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      seen += buckets_[i];
+      if (seen > rank) {
+        return UpperBound(i);
+      }
+    }
+    return 0;
+  }
+
+private:
+  static size_t Index(std::uint64_t ns) {
+    if (ns < 4) {
+      return static_cast<size_t>(ns);
+    }
+    const int exponent = std::bit_width(ns) - 1;
+    const std::uint64_t sub = (ns >> (exponent - 2)) & 3;
+    return static_cast<size_t>(exponent) * 4 + static_cast<size_t>(sub);
+  }
+
+  static std::uint64_t UpperBound(size_t index) {
+    if (index < 4) {
+      return index;
+    }
+    const size_t exponent = index / 4;
+    const std::uint64_t sub = index % 4;
+    return ((4 + sub + 1) << (exponent - 2)) - 1;
+  }
+
+  std::array<std::uint64_t, 64 * 4> buckets_{};
+};
+
+class MutexSignal {
+public:
+  using connection_type = signals2::connection;
+
+  void Emit(int& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    signal_(value);
+  }
+
+  connection_type Connect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return signal_.connect(ContentionSlot);
+  }
+
+  void Disconnect(connection_type& conn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    conn.disconnect();
+  }
+
+private:
+  std::mutex mutex_;
+  signals2::signal2<void, int&> signal_;
+};
+
+class BoostLockedSignal {
+public:
+  using connection_type = boost::signals2::scoped_connection;
+
+  void Emit(int& value) { signal_(value); }
+
+  connection_type Connect() { return signal_.connect(ContentionSlot); }
+
+  void Disconnect(connection_type& conn) { conn.disconnect(); }
+
+private:
+  boost::signals2::signal<void(int&)> signal_;
+};
+
+}  // namespace
+
+template<typename Signal>
+void BenchMarkContention(benchmark::State& state) {
+  const int emitters = static_cast<int>(state.range(0));
+  const int churners = static_cast<int>(state.range(1));
+  const int64_t emits_per_thread = kEmitsPerRound / emitters;
+
+  Signal signal;
+  std::vector<typename Signal::connection_type> fixed;
+  for (int n = 0; n < kFixedSlots; ++n) {
+    fixed.push_back(signal.Connect());
+  }
+
+  LatencyHistogram latency;
+  int64_t emits = 0;
+  int64_t churn_ops = 0;
+  for (auto _ : state) {
+    std::vector<LatencyHistogram> histograms(static_cast<size_t>(emitters));
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::atomic<bool> done{ false };
+    std::atomic<int64_t> churned{ 0 };
+    std::vector<std::thread> threads;
+
+    for (int e = 0; e < emitters; ++e) {
+      threads.emplace_back([&, e] {
+        LatencyHistogram& histogram = histograms[static_cast<size_t>(e)];
+        int sink = 0;
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+        for (int64_t n = 0; n < emits_per_thread; ++n) {
+          const std::uint64_t begin = NowNanoseconds();
+          signal.Emit(sink);
+          histogram.Record(NowNanoseconds() - begin);
+        }
+        benchmark::DoNotOptimize(sink);
+      });
+    }
+    for (int c = 0; c < churners; ++c) {
+      threads.emplace_back([&] {
+        int64_t count = 0;
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+        while (!done.load(std::memory_order_acquire)) {
+          typename Signal::connection_type conn = signal.Connect();
+          signal.Disconnect(conn);
+          ++count;
+        }
+        churned.fetch_add(count);
+      });
+    }
+
+    while (ready.load() != emitters + churners) {
+      std::this_thread::yield();
+    }
+    const auto begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (int e = 0; e < emitters; ++e) {
+      threads[static_cast<size_t>(e)].join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    done.store(true, std::memory_order_release);
+    for (size_t t = static_cast<size_t>(emitters); t < threads.size(); ++t) {
+      threads[t].join();
+    }
+
+    state.SetIterationTime(std::chrono::duration<double>(end - begin).count());
+    for (const LatencyHistogram& histogram : histograms) {
+      latency.Merge(histogram);
+    }
+    emits += emits_per_thread * emitters;
+    churn_ops += churned.load();
+  }
+
+  state.SetItemsProcessed(emits);
+  state.counters["p50_ns"] = static_cast<double>(latency.Percentile(0.5));
+  state.counters["p99_ns"] = static_cast<double>(latency.Percentile(0.99));
+  state.counters["p999_ns"] = static_cast<double>(latency.Percentile(0.999));
+  state.counters["churn_per_second"] = benchmark::Counter(static_cast<double>(churn_ops), benchmark::Counter::kIsRate);
+}
+
+void ContentionArguments(benchmark::internal::Benchmark* b) {
+  b->ArgNames({ "emitters", "churners" });
+  for (int64_t churners : { 0, 1, 4 }) {
+    for (int64_t emitters = 1; emitters <= 64; emitters *= 2) {
+      b->Args({ emitters, churners });
+    }
+  }
+  b->UseManualTime()->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK_TEMPLATE(BenchMarkContention, MutexSignal)->Apply(ContentionArguments);
+BENCHMARK_TEMPLATE(BenchMarkContention, BoostLockedSignal)->Apply(ContentionArguments);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,66 @@
+/**
+ * Argument type that counts its copies and moves, for the heavy-argument
+ * benchmarks.
+ *
+ * Declare a CopyCount right before the timed loop; when it goes out of scope
+ * it publishes copies_per_iter and moves_per_iter for that run. Construction
+ * and destruction of probes are not counted, only copies and moves,
+ * including assignments.
+ */
+
+#ifndef SIGNALS2_TEST_COPY_PROBE_H_
+#define SIGNALS2_TEST_COPY_PROBE_H_
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+
+struct CopyProbe {
+  static inline uint64_t copies = 0;
+  static inline uint64_t moves = 0;
+
+  CopyProbe() = default;
+  explicit CopyProbe(int64_t v) : value(v) {}
+
+  CopyProbe(const CopyProbe& other) : value(other.value) { ++copies; }
+  CopyProbe(CopyProbe&& other) noexcept : value(other.value) { ++moves; }
+
+  CopyProbe& operator=(const CopyProbe& other) {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+
+  CopyProbe& operator=(CopyProbe&& other) noexcept {
+    value = other.value;
+    ++moves;
+    return *this;
+  }
+
+  friend bool operator==(const CopyProbe& a, const CopyProbe& b) { return a.value == b.value; }
+
+  int64_t value = 0;
+};
+
+class CopyCount {
+public:
+  explicit CopyCount(benchmark::State& state)
+    : state_(state), copies_(CopyProbe::copies), moves_(CopyProbe::moves) {}
+
+  ~CopyCount() {
+    state_.counters["copies_per_iter"] = benchmark::Counter(
+      static_cast<double>(CopyProbe::copies - copies_), benchmark::Counter::kAvgIterations);
+    state_.counters["moves_per_iter"] = benchmark::Counter(
+      static_cast<double>(CopyProbe::moves - moves_), benchmark::Counter::kAvgIterations);
+  }
+
+  CopyCount(const CopyCount&) = delete;
+  CopyCount& operator=(const CopyCount&) = delete;
+
+private:
+  benchmark::State& state_;
+  uint64_t copies_;
+  uint64_t moves_;
+};
+
+#endif  // SIGNALS2_TEST_COPY_PROBE_H_
@@ -0,0 +1,85 @@
+/**
+ * @author McMurphy Luo
+ * @description Test cases for the type-indexed event bus (event_bus.h)
+ */
+
+#include "catch_amalgamated.hpp"
+
+#include <signals/event_bus.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct MouseMoved {
+  int x = 0;
+  int y = 0;
+};
+
+struct KeyPressed {
+  std::string key;
+};
+
+}  // namespace
+
+TEST_CASE("event_bus routes each event type to its own handlers") {
+  signals2::event_bus bus;
+  std::vector<signals2::connection> conns;
+  int moves = 0;
+  std::string last_key;
+  conns.push_back(bus.subscribe<MouseMoved>([&](const MouseMoved& e) { moves += e.x; }));
+  conns.push_back(bus.subscribe<KeyPressed>([&](const KeyPressed& e) { last_key = e.key; }));
+
+  bus.publish(MouseMoved{ 3, 4 });
+  bus.publish(KeyPressed{ "a" });
+  CHECK(moves == 3);
+  CHECK(last_key == "a");
+
+  conns.clear();
+  bus.publish(MouseMoved{ 3, 4 });
+  CHECK(moves == 3);
+}
+
+TEST_CASE("event_bus publish without subscribers is a no-op") {
+  signals2::event_bus bus;
+  bus.publish(MouseMoved{ 1, 1 });
+  CHECK(bus.signal<MouseMoved>().begin() == bus.signal<MouseMoved>().end());
+}
+
+TEST_CASE("event_bus instances do not share handlers") {
+  signals2::event_bus first;
+  signals2::event_bus second;
+  int first_calls = 0;
+  signals2::connection conn = first.subscribe<MouseMoved>([&](const MouseMoved&) { ++first_calls; });
+  second.publish(MouseMoved{});
+  CHECK(first_calls == 0);
+  first.publish(MouseMoved{});
+  CHECK(first_calls == 1);
+}
+
+TEST_CASE("event_bus handler subscribed during publish starts with the next publish") {
+  signals2::event_bus bus;
+  std::vector<signals2::connection> conns;
+  int outer_calls = 0;
+  int inner_calls = 0;
+  int key_calls = 0;
+  conns.push_back(bus.subscribe<MouseMoved>([&](const MouseMoved&) {
+    ++outer_calls;
+    if (conns.size() == 1) {
+      conns.push_back(bus.subscribe<MouseMoved>([&](const MouseMoved&) { ++inner_calls; }));
+      // A new event type grows the bus while a publish is running.
+      conns.push_back(bus.subscribe<KeyPressed>([&](const KeyPressed&) { ++key_calls; }));
+    }
+  }));
+
+  bus.publish(MouseMoved{});
+  CHECK(outer_calls == 1);
+  CHECK(inner_calls == 0);
+
+  bus.publish(MouseMoved{});
+  bus.publish(KeyPressed{});
+  CHECK(outer_calls == 2);
+  CHECK(inner_calls == 1);
+  CHECK(key_calls == 1);
+}
@@ -0,0 +1,215 @@
+/**
+ * @author McMurphy Luo
+ * @description Memory footprint of signals, connections, states and computeds
+ *
+ * Heap usage is measured by the counting operator new of signals2_alloc_counter
+ * and is reported in the allocator's usable size, so size-class rounding is
+ * included; the per-block bookkeeping of the allocator is not. The checks are
+ * upper bounds with some headroom over what 64-bit libstdc++ and MSVC need --
+ * a failure means a structure grew, not that the numbers are exact.
+ *
+ * Run `signals2_tests "[footprint]"` to print the full report.
+ */
+
+#include "catch_amalgamated.hpp"
+
+#include <signals/signals.h>
+#include <signals/state.h>
+#include <signals/state_map.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "alloc_counter.h"
+
+namespace {
+
+struct heap_usage {
+  std::int64_t blocks = 0;
+  std::int64_t bytes = 0;
+};
+
+/// Heap blocks and usable bytes allocated and still live since construction.
+class heap_meter {
+public:
+  heap_meter() : start_(alloc_counter::current()) {}
+
+  heap_usage used() const {
+    const alloc_counter::snapshot now = alloc_counter::current();
+    return heap_usage{
+      static_cast<std::int64_t>((now.allocations - start_.allocations) - (now.deallocations - start_.deallocations)),
+      now.live_bytes - start_.live_bytes };
+  }
+
+private:
+  alloc_counter::snapshot start_;
+};
+
+using int_signal = signals2::signal2<void(int)>;
+
+/// A signal with @p slots connected slots, including its connections.
+heap_usage signal_with_slots(std::size_t slots) {
+  std::vector<signals2::connection> conns;
+  conns.reserve(slots);
+  heap_meter meter;
+  int_signal signal;
+  for (std::size_t i = 0; i < slots; ++i) {
+    conns.push_back(signal.connect([](int) {}));
+  }
+  return meter.used();
+}
+
+/// One more connection on a signal that already has one.
+heap_usage extra_connection() {
+  int_signal signal;
+  signals2::connection first = signal.connect([](int) {});
+  heap_meter meter;
+  signals2::connection second = signal.connect([](int) {});
+  return meter.used();
+}
+
+heap_usage state_with_subscribers(std::size_t subscribers) {
+  std::vector<signals2::connection> conns;
+  conns.reserve(subscribers);
+  heap_meter meter;
+  signals2::state<int> value(0);
+  for (std::size_t i = 0; i < subscribers; ++i) {
+    conns.push_back(value.connect([](int) {}));
+  }
+  return meter.used();
+}
+
+/// @p count unobserved state<int> cells, as in a large grid model.
+heap_usage grid_of_states(std::size_t count) {
+  heap_meter meter;
+  std::deque<signals2::state<int>> cells;
+  for (std::size_t i = 0; i < count; ++i) {
+    cells.emplace_back(static_cast<int>(i));
+  }
+  return meter.used();
+}
+
+/// A state_map after @p keys absent keys were each connected to and
+/// disconnected again: the empty cells are swept as they accumulate.
+heap_usage map_after_transient_watches(std::size_t keys) {
+  heap_meter meter;
+  signals2::state_map<int, int> values;
+  for (std::size_t i = 0; i < keys; ++i) {
+    signals2::connection conn = values.connect(static_cast<int>(i), [] {});
+  }
+  return meter.used();
+}
+
+/// A computed reading @p deps states nobody else reads: its dependency list,
+/// its compute function, and in every state the dependent list the first
+/// computed reading it allocates.
+heap_usage computed_with_deps(std::size_t deps) {
+  std::deque<signals2::state<int>> inputs;
+  for (std::size_t i = 0; i < deps; ++i) {
+    inputs.emplace_back(static_cast<int>(i));
+  }
+  heap_meter meter;
+  signals2::computed<int> sum;
+  sum.bind([&inputs] {
+    int total = 0;
+    for (const signals2::state<int>& input : inputs) {
+      total += input.get();
+    }
+    return total;
+  });
+  return meter.used();
+}
+
+void print_row(const char* what, std::size_t object_size, heap_usage heap) {
+  std::printf("  %-40s %6zu B object %4lld blocks %7lld B heap\n", what, object_size,
+              static_cast<long long>(heap.blocks), static_cast<long long>(heap.bytes));
+}
+
+}  // namespace
+
+TEST_CASE("Footprint of a signal and its connections") {
+  const heap_usage empty = signal_with_slots(0);
+  CHECK(empty.blocks == 0);
+  CHECK(empty.bytes == 0);
+  CHECK(sizeof(int_signal) <= 2 * sizeof(void*));
+
+  const heap_usage one = signal_with_slots(1);
+  INFO("one slot: " << one.blocks << " blocks, " << one.bytes << " bytes");
+  CHECK(one.blocks <= 4);
+  CHECK(one.bytes <= 320);
+
+  const heap_usage extra = extra_connection();
+  INFO("extra connection: " << extra.blocks << " blocks, " << extra.bytes << " bytes");
+  CHECK(extra.blocks <= 3);
+  CHECK(extra.bytes <= 160);
+  CHECK(sizeof(signals2::connection) <= sizeof(void*));
+
+  const heap_usage hundred = signal_with_slots(100);
+  INFO("100 slots: " << hundred.blocks << " blocks, " << hundred.bytes << " bytes");
+  CHECK(hundred.bytes <= 100 * 160 + 1024);
+}
+
+TEST_CASE("Footprint of a state") {
+  const heap_usage none = state_with_subscribers(0);
+  CHECK(none.blocks == 0);
+  CHECK(sizeof(signals2::state<int>) <= 2 * sizeof(void*));
+  CHECK(sizeof(signals2::state<bool>) <= 2 * sizeof(void*));
+
+  // The first subscriber also allocates the observer block.
+  const heap_usage one = state_with_subscribers(1);
+  INFO("one subscriber: " << one.blocks << " blocks, " << one.bytes << " bytes");
+  CHECK(one.blocks <= 5);
+  CHECK(one.bytes <= 320);
+}
+
+TEST_CASE("Footprint of a grid of unobserved states") {
+  constexpr std::size_t cells = 100000;
+  const heap_usage grid = grid_of_states(cells);
+  const std::int64_t per_state = grid.bytes / static_cast<std::int64_t>(cells);
+  INFO("per state<int>: " << per_state << " bytes");
+  CHECK(per_state <= 2 * static_cast<std::int64_t>(sizeof(void*)) + 4);
+}
+
+TEST_CASE("Footprint of a state_map does not keep cells nobody observes") {
+  const heap_usage swept = map_after_transient_watches(100000);
+  INFO("after 100000 transient watches: " << swept.blocks << " blocks, " << swept.bytes << " bytes");
+  CHECK(swept.bytes <= 16 * 1024);
+}
+
+TEST_CASE("Footprint of a computed grows linearly with its dependencies") {
+  const heap_usage unbound = computed_with_deps(0);
+  INFO("no dependency: " << unbound.blocks << " blocks, " << unbound.bytes << " bytes");
+  CHECK(unbound.blocks == 0);
+
+  const heap_usage sixteen = computed_with_deps(16);
+  INFO("16 dependencies: " << sixteen.blocks << " blocks, " << sixteen.bytes << " bytes");
+  const std::int64_t per_dependency = (sixteen.bytes - unbound.bytes) / 16;
+  INFO("per dependency: " << per_dependency << " bytes");
+  CHECK(per_dependency <= 96);
+  CHECK(sizeof(signals2::computed<int>) <= 192);
+}
+
+TEST_CASE("Footprint report", "[.][footprint]") {
+  std::printf("\nsignals2 footprint (heap = usable bytes still allocated)\n");
+  print_row("signal2<void(int)>, no slot", sizeof(int_signal), signal_with_slots(0));
+  print_row("signal2<void(int)>, 1 slot", sizeof(int_signal), signal_with_slots(1));
+  print_row("signal2<void(int)>, 10 slots", sizeof(int_signal), signal_with_slots(10));
+  print_row("signal2<void(int)>, 100 slots", sizeof(int_signal), signal_with_slots(100));
+  print_row("connection, on a connected signal", sizeof(signals2::connection), extra_connection());
+  print_row("state<int>, no subscriber", sizeof(signals2::state<int>), state_with_subscribers(0));
+  print_row("state<int>, 1 subscriber", sizeof(signals2::state<int>), state_with_subscribers(1));
+  const heap_usage grid = grid_of_states(100000);
+  std::printf("  %-40s %6zu B object %7lld B heap per state\n", "state<int>, 100000 in a deque",
+              sizeof(signals2::state<int>), static_cast<long long>(grid.bytes / 100000));
+  print_row("state_map<int, int>, 100000 keys watched once", sizeof(signals2::state_map<int, int>),
+            map_after_transient_watches(100000));
+  for (std::size_t deps : { 0, 1, 4, 16, 64 }) {
+    char label[64];
+    std::snprintf(label, sizeof(label), "computed<int>, %zu dependencies", deps);
+    print_row(label, sizeof(signals2::computed<int>), computed_with_deps(deps));
+  }
+  SUCCEED();
+}
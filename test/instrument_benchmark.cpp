@@ -0,0 +1,109 @@
+/**
+ * Overhead of the SIGNALS2_INSTRUMENT build mode.
+ *
+ * This file is built twice: instrument_benchmark without SIGNALS2_INSTRUMENT
+ * and instrument_benchmark_on with it. The hooks compile to nothing in the
+ * first build, so its numbers must match BenchMarkSignalTrigger and
+ * BenchMarkSignalTriggerMultipleSlots in signals_benchmark; a gap there means
+ * something leaked into the disabled path. The second build shows what the
+ * counters cost, with and without a hook installed, and what recording a
+ * trace (trace.h) adds on top.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <signals/signals.h>
+#include "benchmark/benchmark.h"
+#if defined(SIGNALS2_INSTRUMENT)
+#include <signals/trace.h>
+#endif
+
+namespace {
+
+void SimpleSlot(int& i) {
+  ++i;
+  benchmark::DoNotOptimize(i);
+}
+
+}  // namespace
+
+void BenchMarkInstrumentTrigger(benchmark::State& state) {
+  int i = 0;
+  signals2::signal2<void, int&> simple_signal;
+  signals2::connection conn = simple_signal.connect(SimpleSlot);
+  for (auto _ : state) {
+    simple_signal(i);
+  }
+  benchmark::DoNotOptimize(i);
+}
+
+BENCHMARK(BenchMarkInstrumentTrigger);
+
+void BenchMarkInstrumentTriggerMultipleSlots(benchmark::State& state) {
+  int i = 0;
+  signals2::signal2<void, int&> simple_signal;
+  signals2::connection conn_1 = simple_signal.connect(SimpleSlot);
+  signals2::connection conn_2 = simple_signal.connect(SimpleSlot);
+  signals2::connection conn_3 = simple_signal.connect(SimpleSlot);
+  for (auto _ : state) {
+    simple_signal(i);
+  }
+  benchmark::DoNotOptimize(i);
+}
+
+BENCHMARK(BenchMarkInstrumentTriggerMultipleSlots);
+
+#if defined(SIGNALS2_INSTRUMENT)
+void BenchMarkInstrumentTriggerWithHooks(benchmark::State& state) {
+  static std::uint64_t slot_nanoseconds = 0;
+  signals2::instrument::hooks hooks;
+  hooks.emit_begin = [](const signals2::instrument::signal_stats&, std::size_t) {};
+  hooks.emit_end = [](const signals2::instrument::signal_stats*) {};
+  hooks.slot_call = [](const signals2::instrument::signal_stats&, std::uint64_t ns) { slot_nanoseconds += ns; };
+  signals2::instrument::install(hooks);
+
+  int i = 0;
+  signals2::signal2<void, int&> simple_signal;
+  signals2::connection conn = simple_signal.connect(SimpleSlot);
+  for (auto _ : state) {
+    simple_signal(i);
+  }
+  benchmark::DoNotOptimize(i);
+  benchmark::DoNotOptimize(slot_nanoseconds);
+  signals2::instrument::install(signals2::instrument::hooks());
+}
+
+BENCHMARK(BenchMarkInstrumentTriggerWithHooks);
+
+// One recorded span: the cost trace.h adds per emission while recording.
+void BenchMarkTraceSpan(benchmark::State& state) {
+  int object = 0;
+  signals2::trace::start();
+  signals2::trace::detail::thread_buffer& buffer = *signals2::trace::detail::local_buffer();
+  for (auto _ : state) {
+    buffer.begin(signals2::trace::span_kind::signal, &object, nullptr, 1);
+    buffer.end();
+  }
+  signals2::trace::stop();
+  signals2::trace::clear();
+}
+
+BENCHMARK(BenchMarkTraceSpan);
+
+void BenchMarkTraceTrigger(benchmark::State& state) {
+  int i = 0;
+  signals2::signal2<void, int&> simple_signal;
+  signals2::connection conn = simple_signal.connect(SimpleSlot);
+  signals2::trace::start();
+  for (auto _ : state) {
+    simple_signal(i);
+  }
+  signals2::trace::stop();
+  signals2::trace::clear();
+  benchmark::DoNotOptimize(i);
+}
+
+BENCHMARK(BenchMarkTraceTrigger);
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,150 @@
+/**
+ * @author McMurphy Luo
+ * @description Test cases for the SIGNALS2_INSTRUMENT build mode (instrument.h)
+ *
+ * Built into signals2_instrument_tests, which defines SIGNALS2_INSTRUMENT for
+ * the whole executable.
+ */
+
+#include "catch_amalgamated.hpp"
+
+#include <signals/signals.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef SIGNALS2_INSTRUMENT
+#error "instrument_test.cpp must be built with SIGNALS2_INSTRUMENT"
+#endif
+
+namespace {
+
+struct hook_log {
+  int connects = 0;
+  int disconnects = 0;
+  int emit_begins = 0;
+  int emit_ends = 0;
+  int slot_calls = 0;
+  int compactions = 0;
+  std::size_t removed = 0;
+  int lock_allocations = 0;
+  std::size_t last_slot_count = 0;
+  const signals2::instrument::signal_stats* last_signal = nullptr;
+};
+
+hook_log* active_log = nullptr;
+
+signals2::instrument::hooks logging_hooks() {
+  signals2::instrument::hooks h;
+  h.connect = [](const signals2::instrument::signal_stats& s) { ++active_log->connects; active_log->last_signal = &s; };
+  h.disconnect = [](const signals2::instrument::signal_stats&) { ++active_log->disconnects; };
+  h.emit_begin = [](const signals2::instrument::signal_stats&, std::size_t slots) {
+    ++active_log->emit_begins;
+    active_log->last_slot_count = slots;
+  };
+  h.emit_end = [](const signals2::instrument::signal_stats*) { ++active_log->emit_ends; };
+  h.slot_call = [](const signals2::instrument::signal_stats&, std::uint64_t) { ++active_log->slot_calls; };
+  h.compact = [](const signals2::instrument::signal_stats&, std::size_t removed) {
+    ++active_log->compactions;
+    active_log->removed += removed;
+  };
+  h.lock_allocate = [](const signals2::instrument::signal_stats&) { ++active_log->lock_allocations; };
+  return h;
+}
+
+// Installs the logging hooks for one test case and restores the empty set.
+class scoped_hooks {
+public:
+  explicit scoped_hooks(hook_log& log) {
+    active_log = &log;
+    signals2::instrument::install(logging_hooks());
+  }
+
+  ~scoped_hooks() {
+    signals2::instrument::install(signals2::instrument::hooks());
+    active_log = nullptr;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Instrumented signal counts emits, slot calls and dead slots") {
+  signals2::signal2<void, int&> test_signal;
+  CHECK(test_signal.stats() == nullptr);
+  test_signal.set_name("test_signal");
+  signals2::connection conn_1;
+  signals2::connection conn_2 = test_signal.connect([&conn_1](int& v) { ++v; conn_1.disconnect(); });
+  conn_1 = test_signal.connect([](int& v) { ++v; });
+  signals2::connection conn_3 = test_signal.connect([](int& v) { ++v; });
+
+  int value = 0;
+  test_signal(value);
+  const signals2::instrument::signal_stats* stats = test_signal.stats();
+  REQUIRE(stats != nullptr);
+  CHECK(stats->name != nullptr);
+  CHECK(stats->emits == 1);
+  CHECK(stats->slot_calls == 2);
+  CHECK(stats->dead_slot_skips == 1);
+  CHECK(value == 2);
+
+  test_signal(value);
+  CHECK(stats->emits == 2);
+  CHECK(stats->slot_calls == 4);
+  CHECK(stats->dead_slot_skips == 1);
+}
+
+TEST_CASE("Instrumentation hooks see the signal lifecycle") {
+  hook_log log;
+  scoped_hooks installed(log);
+  {
+    signals2::signal2<void> test_signal;
+    signals2::connection conn_1 = test_signal.connect([] {});
+    signals2::connection conn_2;
+    signals2::connection conn_3 = test_signal.connect([&conn_2] { conn_2.disconnect(); });
+    conn_2 = test_signal.connect([] {});
+    CHECK(log.connects == 3);
+    CHECK(log.last_signal == test_signal.stats());
+
+    test_signal();
+    CHECK(log.lock_allocations == 1);
+    CHECK(log.emit_begins == 1);
+    CHECK(log.emit_ends == 1);
+    CHECK(log.last_slot_count == 3);
+    CHECK(log.slot_calls == 2);
+    CHECK(log.disconnects == 1);
+    CHECK(log.compactions == 1);
+    CHECK(log.removed == 1);
+
+    test_signal();
+    CHECK(log.lock_allocations == 1);
+    CHECK(log.last_slot_count == 2);
+  }
+  CHECK(log.disconnects == 3);
+}
+
+TEST_CASE("Instrumentation hooks follow forwarding edges") {
+  hook_log log;
+  scoped_hooks installed(log);
+  signals2::signal2<void> upstream;
+  signals2::signal2<void> downstream;
+  signals2::connection edge = upstream.forward_to(downstream);
+  signals2::connection conn = downstream.connect([] {});
+  upstream();
+  CHECK(log.emit_begins == 2);
+  CHECK(log.emit_ends == 2);
+  CHECK(log.slot_calls == 1);
+  CHECK(downstream.stats()->emits == 1);
+}
+
+TEST_CASE("Instrumentation reports the end of an emission that destroyed its signal") {
+  hook_log log;
+  scoped_hooks installed(log);
+  std::vector<signals2::connection> conns;
+  auto* test_signal = new signals2::signal2<void>();
+  conns.push_back(test_signal->connect([&test_signal] { delete test_signal; test_signal = nullptr; }));
+  (*test_signal)();
+  CHECK(test_signal == nullptr);
+  CHECK(log.emit_begins == 1);
+  CHECK(log.emit_ends == 1);
+}
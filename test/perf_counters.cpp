@@ -0,0 +1,175 @@
+#include "perf_counters.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perf_counters {
+
+namespace {
+
+const char* const names[event_count] = {
+  "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+};
+
+bool requested() {
+  const char* value = std::getenv("SIGNALS2_PERF_COUNTERS");
+  return value && *value && std::strcmp(value, "0") != 0;
+}
+
+#if defined(__linux__)
+
+struct event_config {
+  std::uint32_t type;
+  std::uint64_t config;
+};
+
+const event_config configs[event_count] = {
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+struct counters {
+  int fds[event_count];
+  bool any_open = false;
+
+  counters() {
+    for (int& fd : fds) {
+      fd = -1;
+    }
+    if (!requested()) {
+      return;
+    }
+    int errors[event_count] = {};
+    for (std::size_t i = 0; i < event_count; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = configs[i].type;
+      attr.config = configs[i].config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+      if (fd < 0) {
+        errors[i] = errno;
+        continue;
+      }
+      fds[i] = static_cast<int>(fd);
+      any_open = true;
+    }
+    if (!any_open) {
+      std::fprintf(stderr, "perf_counters: no hardware counters (%s), running without them%s\n",
+                   std::strerror(errors[0]),
+                   errors[0] == EACCES || errors[0] == EPERM ? "; see /proc/sys/kernel/perf_event_paranoid" : "");
+      return;
+    }
+    for (std::size_t i = 0; i < event_count; ++i) {
+      if (fds[i] < 0) {
+        std::fprintf(stderr, "perf_counters: %s unavailable: %s\n", names[i], std::strerror(errors[i]));
+      }
+    }
+  }
+
+  ~counters() {
+    for (int fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  counters(const counters&) = delete;
+  counters& operator=(const counters&) = delete;
+};
+
+counters& instance() {
+  static counters c;
+  return c;
+}
+
+#endif  // __linux__
+
+}  // namespace
+
+const char* name(std::size_t index) {
+  return names[index];
+}
+
+#if defined(__linux__)
+
+bool available() {
+  return instance().any_open;
+}
+
+void start() {
+  counters& c = instance();
+  for (int fd : c.fds) {
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    }
+  }
+  for (int fd : c.fds) {
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+}
+
+sample stop() {
+  counters& c = instance();
+  for (int fd : c.fds) {
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  sample result;
+  for (std::size_t i = 0; i < event_count; ++i) {
+    if (c.fds[i] < 0) {
+      continue;
+    }
+    // value, time enabled, time running
+    std::uint64_t data[3] = {};
+    if (read(c.fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+      continue;
+    }
+    double value = static_cast<double>(data[0]);
+    if (data[2] < data[1]) {
+      value *= static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    }
+    result.values[i] = static_cast<std::uint64_t>(value);
+    result.valid[i] = true;
+  }
+  return result;
+}
+
+#else
+
+bool available() {
+  static const bool note = requested() && std::fprintf(stderr, "perf_counters: only supported on Linux\n") > 0;
+  (void)note;
+  return false;
+}
+
+void start() {}
+
+sample stop() {
+  return sample{};
+}
+
+#endif  // __linux__
+
+}  // namespace perf_counters
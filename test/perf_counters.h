@@ -0,0 +1,47 @@
+/**
+ * Hardware performance counters for benchmark loops, through perf_event_open.
+ *
+ * Opt-in: nothing is opened unless the SIGNALS2_PERF_COUNTERS environment
+ * variable is set to a non-empty value other than "0". Each event is opened
+ * on its own, so an event the CPU or hypervisor does not expose only drops
+ * that one value; when the kernel forbids counters altogether (see
+ * /proc/sys/kernel/perf_event_paranoid) available() returns false after one
+ * note on stderr, and the benchmarks run as usual without them.
+ *
+ * Counters measure user-space work of the calling thread only. Linux only;
+ * elsewhere available() is always false.
+ */
+
+#ifndef SIGNALS2_TEST_PERF_COUNTERS_H_
+#define SIGNALS2_TEST_PERF_COUNTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace perf_counters {
+
+inline constexpr std::size_t event_count = 5;
+
+struct sample {
+  std::uint64_t values[event_count] = {};
+  bool valid[event_count] = {};
+};
+
+/// Counter name of event @p index: cycles, instructions, l1d_misses,
+/// llc_misses or branch_misses.
+const char* name(std::size_t index);
+
+/// Requested through the environment and at least one event could be opened.
+/// Opens the events on first call.
+bool available();
+
+/// Reset and enable every open event.
+void start();
+
+/// Disable the events and read what they counted since start(). Values are
+/// scaled up when the kernel multiplexed an event.
+sample stop();
+
+}  // namespace perf_counters
+
+#endif  // SIGNALS2_TEST_PERF_COUNTERS_H_
@@ -13,14 +13,26 @@
  * symmetric and the slot list bounded. If you would rather measure connect
  * alone as the slot list grows, both sides must retain their connections --
  * and then both need a periodic, timing-paused clear to bound memory.
+ *
+ * Benchmarks whose loop does not pause timing report allocs_per_iter and
+ * bytes_per_iter through bench_probe (see bench_probe.h).
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <random>
+#include <string>
+#include <vector>
 #include <signals/signals.h>
+#include <signals/event_bus.h>
 #include "boost/signals2.hpp"
 #include "benchmark/benchmark.h"
+#include "bench_probe.h"
+#include "copy_probe.h"
 
 void SimpleSlot(int& i) {
   ++i;
@@ -29,6 +41,7 @@ void SimpleSlot(int& i) {
 
 void BenchMarkZero(benchmark::State& state) {
   int i = 2;
+  bench_probe probe(state);
   for (auto _ : state) {
     SimpleSlot(i);
   }
@@ -38,6 +51,7 @@ void BenchMarkZero(benchmark::State& state) {
 BENCHMARK(BenchMarkZero);
 
 void BenchMarkSimpleNewFree(benchmark::State& state) {
+  bench_probe probe(state);
   for (auto _ : state) {
     int* p_test = new int{ 5 };
     benchmark::DoNotOptimize(p_test);
@@ -48,6 +62,7 @@ void BenchMarkSimpleNewFree(benchmark::State& state) {
 BENCHMARK(BenchMarkSimpleNewFree);
 
 void BenchMarkSharedPtr(benchmark::State& state) {
+  bench_probe probe(state);
   for (auto _ : state) {
     // Bound and clobbered: a discarded make_shared has no observable effect
     // and the allocation is free to be elided.
@@ -60,6 +75,7 @@ BENCHMARK(BenchMarkSharedPtr);
 
 void BenchMarkSignalConnectDisconnect(benchmark::State& state) {
   signals2::signal2<void, int&> simple_signal;
+  bench_probe probe(state);
   for (auto _ : state) {
     signals2::connection conn = simple_signal.connect(SimpleSlot);
     benchmark::DoNotOptimize(conn);
@@ -70,6 +86,7 @@ BENCHMARK(BenchMarkSignalConnectDisconnect);
 
 void BenchMarkBoostConnectDisconnect(benchmark::State& state) {
   boost::signals2::signal<void(int&)> simple_signal;
+  bench_probe probe(state);
   for (auto _ : state) {
     boost::signals2::scoped_connection conn = simple_signal.connect(SimpleSlot);
     benchmark::DoNotOptimize(conn);
@@ -81,6 +98,7 @@ BENCHMARK(BenchMarkBoostConnectDisconnect);
 void BenchMarkSimpleFunctionObject(benchmark::State& state) {
   std::function<void(int&)> f(SimpleSlot);
   int i = 0;
+  bench_probe probe(state);
   for (auto _ : state) {
     f(i);
   }
@@ -93,6 +111,7 @@ void BenchMarkSignalTrigger(benchmark::State& state) {
   int i = 0;
   signals2::signal2<void, int&> simple_signal;
   signals2::connection conn = simple_signal.connect(SimpleSlot);
+  bench_probe probe(state);
   for (auto _ : state) {
     simple_signal(i);
   }
@@ -101,10 +120,26 @@ void BenchMarkSignalTrigger(benchmark::State& state) {
 
 BENCHMARK(BenchMarkSignalTrigger);
 
+// A signal's whole life: construct, connect, emit once, destroy. The first
+// emission is the one that allocates the signal_lock.
+void BenchMarkSignalFirstEmit(benchmark::State& state) {
+  int i = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    signals2::signal2<void, int&> simple_signal;
+    signals2::connection conn = simple_signal.connect(SimpleSlot);
+    simple_signal(i);
+  }
+  benchmark::DoNotOptimize(i);
+}
+
+BENCHMARK(BenchMarkSignalFirstEmit);
+
 void BenchMarkBoostTrigger(benchmark::State& state) {
   int i = 0;
   boost::signals2::signal<void(int&)> simple_signal;
   boost::signals2::connection conn = simple_signal.connect(SimpleSlot);
+  bench_probe probe(state);
   for (auto _ : state) {
     simple_signal(i);
   }
@@ -119,6 +154,7 @@ void BenchMarkSignalTriggerMultipleSlots(benchmark::State& state) {
   signals2::connection conn_1 = simple_signal.connect(SimpleSlot);
   signals2::connection conn_2 = simple_signal.connect(SimpleSlot);
   signals2::connection conn_3 = simple_signal.connect(SimpleSlot);
+  bench_probe probe(state);
   for (auto _ : state) {
     simple_signal(i);
   }
@@ -133,6 +169,7 @@ void BenchMarkBoostTriggerMultipleSlots(benchmark::State& state) {
   boost::signals2::connection conn_1 = simple_signal.connect(SimpleSlot);
   boost::signals2::connection conn_2 = simple_signal.connect(SimpleSlot);
   boost::signals2::connection conn_3 = simple_signal.connect(SimpleSlot);
+  bench_probe probe(state);
   for (auto _ : state) {
     simple_signal(i);
   }
@@ -153,6 +190,7 @@ void TestClass::Test(int i) {
 void BenchMarkSignalConnectDisconnectClassMemberFunction(benchmark::State& state) {
   signals2::signal2<void, int> simple_signal;
   TestClass obj;
+  bench_probe probe(state);
   for (auto _ : state) {
     signals2::connection conn = simple_signal.connect(&obj, &TestClass::Test);
     benchmark::DoNotOptimize(conn);
@@ -165,6 +203,7 @@ BENCHMARK(BenchMarkSignalConnectDisconnectClassMemberFunction);
 void BenchMarkBoostConnectDisconnectClassMemberFunction(benchmark::State& state) {
   boost::signals2::signal<void(int)> simple_signal;
   TestClass obj;
+  bench_probe probe(state);
   for (auto _ : state) {
     boost::signals2::scoped_connection conn = simple_signal.connect(
         boost::bind(&TestClass::Test, &obj, boost::placeholders::_1));
@@ -174,4 +213,452 @@ void BenchMarkBoostConnectDisconnectClassMemberFunction(benchmark::State& state)
 
 BENCHMARK(BenchMarkBoostConnectDisconnectClassMemberFunction);
 
+// Four hops: the relay chain connects a lambda per hop, the forward chain uses
+// native edges.
+void BenchMarkSignalRelayChain(benchmark::State& state) {
+  int i = 0;
+  signals2::signal2<void, int&> hops[4];
+  std::vector<signals2::connection> conns;
+  for (int hop = 0; hop + 1 < 4; ++hop) {
+    signals2::signal2<void, int&>* next = &hops[hop + 1];
+    conns.push_back(hops[hop].connect([next](int& v) { (*next)(v); }));
+  }
+  conns.push_back(hops[3].connect(SimpleSlot));
+  bench_probe probe(state);
+  for (auto _ : state) {
+    hops[0](i);
+  }
+  benchmark::DoNotOptimize(i);
+}
+
+BENCHMARK(BenchMarkSignalRelayChain);
+
+void BenchMarkSignalForwardChain(benchmark::State& state) {
+  int i = 0;
+  signals2::signal2<void, int&> hops[4];
+  std::vector<signals2::connection> conns;
+  for (int hop = 0; hop + 1 < 4; ++hop) {
+    conns.push_back(hops[hop].forward_to(hops[hop + 1]));
+  }
+  conns.push_back(hops[3].connect(SimpleSlot));
+  bench_probe probe(state);
+  for (auto _ : state) {
+    hops[0](i);
+  }
+  benchmark::DoNotOptimize(i);
+}
+
+BENCHMARK(BenchMarkSignalForwardChain);
+
+// ---- Scaling families ----
+//
+// Each family below is a template instantiated for both libraries, over 1 to
+// 100k slots. boost uses scoped_connection so that both sides own their
+// connections (see the note at the top of this file). Slot lists are built
+// with the timer paused; only the operation named by the benchmark is timed.
+
+using SignalsSignal = signals2::signal2<void, int&>;
+using SignalsConnection = signals2::connection;
+using BoostSignal = boost::signals2::signal<void(int&)>;
+using BoostConnection = boost::signals2::scoped_connection;
+
+enum class DisconnectOrder { kFifo, kLifo, kRandom };
+
+void ScalingArguments(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(10)->Range(1, 100000);
+}
+
+template<typename Signal, typename Connection>
+void ConnectSlots(Signal& signal, std::vector<Connection>& conns, int64_t count) {
+  conns.reserve(conns.size() + static_cast<size_t>(count));
+  for (int64_t n = 0; n < count; ++n) {
+    conns.emplace_back(signal.connect(SimpleSlot));
+  }
+}
+
+template<typename Signal, typename Connection>
+void BenchMarkEmitScaling(benchmark::State& state) {
+  int i = 0;
+  Signal signal;
+  std::vector<Connection> conns;
+  ConnectSlots(signal, conns, state.range(0));
+  bench_probe probe(state);
+  for (auto _ : state) {
+    signal(i);
+  }
+  benchmark::DoNotOptimize(i);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BenchMarkEmitScaling, SignalsSignal, SignalsConnection)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkEmitScaling, BoostSignal, BoostConnection)->Apply(ScalingArguments);
+
+template<typename Signal, typename Connection, DisconnectOrder Order>
+void BenchMarkDisconnectScaling(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Signal signal;
+  std::vector<size_t> order(count);
+  for (size_t n = 0; n < count; ++n) {
+    order[n] = Order == DisconnectOrder::kLifo ? count - 1 - n : n;
+  }
+  if (Order == DisconnectOrder::kRandom) {
+    std::mt19937 rng(42);
+    std::shuffle(order.begin(), order.end(), rng);
+  }
+  std::vector<Connection> conns;
+  for (auto _ : state) {
+    state.PauseTiming();
+    conns.clear();
+    ConnectSlots(signal, conns, state.range(0));
+    state.ResumeTiming();
+    for (size_t index : order) {
+      conns[index].disconnect();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BenchMarkDisconnectScaling, SignalsSignal, SignalsConnection, DisconnectOrder::kFifo)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkDisconnectScaling, BoostSignal, BoostConnection, DisconnectOrder::kFifo)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkDisconnectScaling, SignalsSignal, SignalsConnection, DisconnectOrder::kLifo)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkDisconnectScaling, BoostSignal, BoostConnection, DisconnectOrder::kLifo)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkDisconnectScaling, SignalsSignal, SignalsConnection, DisconnectOrder::kRandom)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkDisconnectScaling, BoostSignal, BoostConnection, DisconnectOrder::kRandom)->Apply(ScalingArguments);
+
+// The same teardown through signals2::disconnect_all, which compacts once.
+void BenchMarkDisconnectAllScaling(benchmark::State& state) {
+  SignalsSignal signal;
+  std::vector<SignalsConnection> conns;
+  for (auto _ : state) {
+    state.PauseTiming();
+    conns.clear();
+    ConnectSlots(signal, conns, state.range(0));
+    state.ResumeTiming();
+    signals2::disconnect_all(conns);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchMarkDisconnectAllScaling)->Apply(ScalingArguments);
+
+// One slot connects a new slot on every emission; the new slot is dropped
+// after the emission returns, so the list stays at N + 1.
+template<typename Signal, typename Connection>
+void BenchMarkConnectWhileEmittingScaling(benchmark::State& state) {
+  int i = 0;
+  Signal signal;
+  std::vector<Connection> conns;
+  Connection added;
+  ConnectSlots(signal, conns, state.range(0) - 1);
+  conns.emplace_back(signal.connect([&signal, &added](int& v) {
+    ++v;
+    added = signal.connect(SimpleSlot);
+  }));
+  bench_probe probe(state);
+  for (auto _ : state) {
+    signal(i);
+    added.disconnect();
+  }
+  benchmark::DoNotOptimize(i);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BenchMarkConnectWhileEmittingScaling, SignalsSignal, SignalsConnection)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkConnectWhileEmittingScaling, BoostSignal, BoostConnection)->Apply(ScalingArguments);
+
+// Every slot disconnects itself while the signal emits: signals2 defers each
+// removal through signal_lock::invalid() and compacts once at the end.
+template<typename Signal, typename Connection>
+void BenchMarkDisconnectSelfScaling(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  int i = 0;
+  Signal signal;
+  std::vector<Connection> conns;
+  for (auto _ : state) {
+    state.PauseTiming();
+    conns.clear();
+    conns.resize(count);
+    for (size_t n = 0; n < count; ++n) {
+      conns[n] = signal.connect([&conns, n](int& v) {
+        ++v;
+        conns[n].disconnect();
+      });
+    }
+    state.ResumeTiming();
+    signal(i);
+  }
+  benchmark::DoNotOptimize(i);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BenchMarkDisconnectSelfScaling, SignalsSignal, SignalsConnection)->Apply(ScalingArguments);
+BENCHMARK_TEMPLATE(BenchMarkDisconnectSelfScaling, BoostSignal, BoostConnection)->Apply(ScalingArguments);
+
+// ---- Heavy arguments ----
+//
+// operator()(A... param) takes its arguments by value and hands them to every
+// slot's std::function, so a by-value signature costs N + 1 copies for N
+// slots: one into operator(), one per slot. A const& signature costs none. Each
+// family emits an lvalue through 1 to 10 slots that take const&; the probe
+// counts copies and moves, the string and vector cases show up in
+// allocs_per_iter.
+
+void HeavyArgumentSlots(benchmark::internal::Benchmark* b) {
+  b->Arg(1)->Arg(3)->Arg(10);
+}
+
+void BenchMarkStringArgument(benchmark::State& state) {
+  signals2::signal2<void, std::string> signal;
+  std::vector<signals2::connection> conns;
+  size_t total = 0;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    conns.push_back(signal.connect([&total](const std::string& s) { total += s.size(); }));
+  }
+  const std::string payload(64, 'x');  // past any small-string buffer
+  bench_probe probe(state);
+  for (auto _ : state) {
+    signal(payload);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+BENCHMARK(BenchMarkStringArgument)->Apply(HeavyArgumentSlots);
+
+void BenchMarkVectorRefArgument(benchmark::State& state) {
+  signals2::signal2<void, const std::vector<int>&> signal;
+  std::vector<signals2::connection> conns;
+  size_t total = 0;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    conns.push_back(signal.connect([&total](const std::vector<int>& v) { total += v.size(); }));
+  }
+  const std::vector<int> payload(1024, 1);
+  bench_probe probe(state);
+  for (auto _ : state) {
+    signal(payload);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+BENCHMARK(BenchMarkVectorRefArgument)->Apply(HeavyArgumentSlots);
+
+template<typename Arg>
+void BenchMarkCopyProbeArgument(benchmark::State& state) {
+  signals2::signal2<void, Arg> signal;
+  std::vector<signals2::connection> conns;
+  int64_t total = 0;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    conns.push_back(signal.connect([&total](const CopyProbe& p) { total += p.value; }));
+  }
+  const CopyProbe payload(1);
+  CopyCount copies(state);
+  for (auto _ : state) {
+    signal(payload);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+BENCHMARK_TEMPLATE(BenchMarkCopyProbeArgument, CopyProbe)->Apply(HeavyArgumentSlots);
+BENCHMARK_TEMPLATE(BenchMarkCopyProbeArgument, const CopyProbe&)->Apply(HeavyArgumentSlots);
+
+// ---- Churn stress ----
+//
+// Seeded random churn: every slot call may connect a new slot, disconnect
+// itself, disconnect another slot or destroy the signal, each at a rate given
+// in per mille by the arguments. One iteration is one emission; the
+// population is topped back up between emissions. Every emission checks the
+// rules signals_test.cpp pins down by hand:
+//   - a disconnected slot is never called again;
+//   - a slot connected during an emission is first called by the next one;
+//   - no slot is called twice in one emission, and every slot connected
+//     before the emission and still connected after it was called;
+//   - nothing is called once a slot has destroyed the signal, and every
+//     connection reports !connected() afterwards;
+//   - after the emission the signal holds exactly the live slots.
+// A violation stops the benchmark with SkipWithError.
+
+class ChurnWorld {
+public:
+  // Per mille per slot call.
+  struct Rates {
+    int64_t connect;
+    int64_t disconnect_self;
+    int64_t disconnect_other;
+    int64_t destroy;
+  };
+
+  ChurnWorld(Rates rates, size_t population, uint32_t seed)
+    : rates_(rates), population_(population), rng_(seed) {}
+
+  void Emit() {
+    if (!signal_) {
+      signal_ = std::make_unique<SignalsSignal>();
+      entries_.clear();
+    }
+    // The signal is not emitting, so everything disconnected has been
+    // compacted away and no slot can still reach these entries.
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+      [](const std::unique_ptr<Entry>& entry) { return entry->disconnected; }), entries_.end());
+    while (entries_.size() < population_) {
+      Connect();
+    }
+
+    ++emission_;
+    for (const std::unique_ptr<Entry>& entry : entries_) {
+      entry->expected = true;
+    }
+    destroyed_ = false;
+    int value = 0;
+    (*signal_)(value);
+
+    if (destroyed_) {
+      for (const std::unique_ptr<Entry>& entry : entries_) {
+        if (entry->conn.connected()) {
+          Fail("a connection survived the destruction of its signal");
+        }
+      }
+      return;
+    }
+    size_t live = 0;
+    for (const std::unique_ptr<Entry>& entry : entries_) {
+      if (entry->disconnected) {
+        if (entry->conn.connected()) {
+          Fail("a disconnected connection reports connected()");
+        }
+        continue;
+      }
+      ++live;
+      if (entry->expected && entry->last_called != emission_) {
+        Fail("a connected slot was skipped");
+      }
+      if (!entry->conn.connected()) {
+        Fail("a live connection reports !connected()");
+      }
+    }
+    if (static_cast<size_t>(std::distance(signal_->cbegin(), signal_->cend())) != live) {
+      Fail("the signal does not hold exactly the live slots");
+    }
+  }
+
+  const std::string& Error() const { return error_; }
+
+  uint64_t SlotCalls() const { return slot_calls_; }
+  uint64_t Destroys() const { return destroys_; }
+
+private:
+  struct Entry {
+    SignalsConnection conn;
+    uint64_t connected_in = 0;
+    uint64_t last_called = 0;
+    bool expected = false;
+    bool disconnected = false;
+  };
+
+  void Connect() {
+    entries_.push_back(std::make_unique<Entry>());
+    Entry* entry = entries_.back().get();
+    entry->connected_in = emission_;
+    entry->conn = signal_->connect([this, entry](int& v) { OnCall(entry, v); });
+  }
+
+  void OnCall(Entry* self, int& v) {
+    ++v;
+    ++slot_calls_;
+    if (destroyed_) {
+      Fail("a slot was called after the signal was destroyed");
+    }
+    if (self->disconnected) {
+      Fail("a disconnected slot was called");
+    }
+    if (!self->expected) {
+      Fail("a slot connected during an emission was called by it");
+    }
+    if (self->last_called == emission_) {
+      Fail("a slot was called twice in one emission");
+    }
+    self->last_called = emission_;
+
+    std::uniform_int_distribution<int64_t> roll(0, 999);
+    if (roll(rng_) < rates_.destroy) {
+      for (const std::unique_ptr<Entry>& entry : entries_) {
+        entry->disconnected = true;
+      }
+      destroyed_ = true;
+      ++destroys_;
+      signal_.reset();
+      return;  // self's slot stays owned by its connection until Emit() drops it
+    }
+    if (roll(rng_) < rates_.connect) {
+      Connect();
+    }
+    if (roll(rng_) < rates_.disconnect_other) {
+      std::uniform_int_distribution<size_t> pick(0, entries_.size() - 1);
+      Entry& other = *entries_[pick(rng_)];
+      other.conn.disconnect();
+      other.disconnected = true;
+    }
+    if (roll(rng_) < rates_.disconnect_self) {
+      self->conn.disconnect();
+      self->disconnected = true;
+    }
+  }
+
+  void Fail(const char* message) {
+    if (error_.empty()) {
+      error_ = message;
+    }
+  }
+
+  Rates rates_;
+  size_t population_;
+  std::mt19937 rng_;
+  std::unique_ptr<SignalsSignal> signal_;
+  std::vector<std::unique_ptr<Entry>> entries_;
+  uint64_t emission_ = 0;
+  bool destroyed_ = false;
+  uint64_t slot_calls_ = 0;
+  uint64_t destroys_ = 0;
+  std::string error_;
+};
+
+// Args: connect, disconnect self, disconnect other, destroy -- per mille per
+// slot call. 32 slots are connected at the start of every emission.
+void BenchMarkChurnStress(benchmark::State& state) {
+  ChurnWorld world(ChurnWorld::Rates{ state.range(0), state.range(1), state.range(2), state.range(3) }, 32, 42);
+  for (auto _ : state) {
+    world.Emit();
+    if (!world.Error().empty()) {
+      state.SkipWithError(world.Error().c_str());
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["slot_calls_per_emit"] =
+    benchmark::Counter(static_cast<double>(world.SlotCalls()), benchmark::Counter::kAvgIterations);
+  state.counters["destroys"] = static_cast<double>(world.Destroys());
+}
+
+BENCHMARK(BenchMarkChurnStress)
+  ->ArgNames({ "connect", "self", "other", "destroy" })
+  ->Args({ 0, 0, 0, 0 })
+  ->Args({ 50, 50, 50, 0 })
+  ->Args({ 250, 250, 250, 0 })
+  ->Args({ 50, 50, 50, 5 });
+
+struct BenchEvent {
+  int value;
+};
+
+void BenchMarkEventBusPublish(benchmark::State& state) {
+  int i = 0;
+  signals2::event_bus bus;
+  signals2::connection conn = bus.subscribe<BenchEvent>([&i](const BenchEvent& e) { i += e.value; });
+  bench_probe probe(state);
+  for (auto _ : state) {
+    bus.publish(BenchEvent{ 1 });
+  }
+  benchmark::DoNotOptimize(i);
+}
+
+BENCHMARK(BenchMarkEventBusPublish);
+
 BENCHMARK_MAIN();
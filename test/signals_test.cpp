@@ -454,3 +454,210 @@ TEST_CASE("Test connected") {
   }
   CHECK(!conn_signal.connected());
 }
+
+TEST_CASE("Test empty") {
+  signals2::signal2<void> test_signal;
+  signals2::signal2<void> downstream;
+  CHECK(test_signal.empty());
+  signals2::connection conn = test_signal.connect([] {});
+  CHECK(!test_signal.empty());
+  conn.disconnect();
+  CHECK(test_signal.empty());
+
+  signals2::connection edge = test_signal.forward_to(downstream);
+  CHECK(!test_signal.empty());
+  CHECK(downstream.empty());
+  edge.disconnect();
+  CHECK(test_signal.empty());
+
+  // A slot disconnected while the signal is locked no longer counts, though
+  // it stays in the list until the lock is released.
+  conn = test_signal.connect([] {});
+  {
+    signals2::signal2<void>::const_iterator it = test_signal.cbegin();
+    conn.disconnect();
+    CHECK(test_signal.empty());
+  }
+  CHECK(test_signal.empty());
+}
+
+TEST_CASE("Test disconnect all") {
+  signals2::signal2<void> signal_a;
+  signals2::signal2<void, int> signal_b;
+  int a_called_times = 0;
+  int b_called_times = 0;
+  std::vector<signals2::connection> connections;
+  for (int i = 0; i < 8; ++i) {
+    connections.push_back(signal_a.connect([&a_called_times] { ++a_called_times; }));
+    connections.push_back(signal_b.connect([&b_called_times](int) { ++b_called_times; }));
+  }
+  signals2::connection kept = signal_a.connect([&a_called_times] { ++a_called_times; });
+  signal_a();
+  signal_b(1);
+  CHECK(a_called_times == 9);
+  CHECK(b_called_times == 8);
+
+  signals2::disconnect_all(connections);
+  for (const signals2::connection& conn : connections) {
+    CHECK(!conn.connected());
+  }
+  CHECK(signal_a.signal_detail_->connections_.size() == 1);
+  CHECK(signal_b.signal_detail_->connections_.empty());
+  signal_a();
+  signal_b(1);
+  CHECK(a_called_times == 10);
+  CHECK(b_called_times == 8);
+  CHECK(kept.connected());
+
+  // Disconnecting twice, or a range whose signal is already gone, is harmless.
+  signals2::disconnect_all(connections);
+  {
+    signals2::signal2<void> short_lived;
+    connections.push_back(short_lived.connect([] {}));
+  }
+  signals2::disconnect_all(connections);
+  CHECK(!connections.back().connected());
+}
+
+TEST_CASE("Test disconnect all across many signals") {
+  std::vector<signals2::signal2<void>> signals(400);
+  std::vector<signals2::connection> connections;
+  // Two connections per signal, and no two of one signal next to each other.
+  for (int round = 0; round < 2; ++round) {
+    for (signals2::signal2<void>& signal : signals) {
+      connections.push_back(signal.connect([] {}));
+    }
+  }
+  signals2::disconnect_all(connections);
+  for (const signals2::signal2<void>& signal : signals) {
+    CHECK(signal.signal_detail_->connections_.empty());
+  }
+}
+
+TEST_CASE("Test disconnect all during emission") {
+  signals2::signal2<void> test_signal;
+  int called_times = 0;
+  std::vector<signals2::connection> connections;
+  signals2::connection trigger = test_signal.connect([&connections] {
+    signals2::disconnect_all(connections);
+  });
+  for (int i = 0; i < 4; ++i) {
+    connections.push_back(test_signal.connect([&called_times] { ++called_times; }));
+  }
+  test_signal();
+  CHECK(called_times == 0);
+  CHECK(test_signal.signal_detail_->connections_.size() == 1);
+  test_signal();
+  CHECK(called_times == 0);
+}
+
+TEST_CASE("Test forward to another signal") {
+  signals2::signal2<void, int&> upstream;
+  signals2::signal2<void, int&> middle;
+  signals2::signal2<void, int&> downstream;
+  std::vector<int> order;
+  signals2::connection conn_up = upstream.connect([&order](int& v) { order.push_back(1); ++v; });
+  signals2::connection conn_down = downstream.connect([&order](int& v) { order.push_back(3); ++v; });
+  signals2::connection edge_1 = upstream.forward_to(middle);
+  signals2::connection edge_2 = middle.forward_to(downstream);
+  signals2::connection conn_middle = middle.connect([&order](int& v) { order.push_back(2); ++v; });
+  CHECK(edge_1.connected());
+
+  int value = 0;
+  upstream(value);
+  CHECK(value == 3);
+  CHECK(order == std::vector<int>{ 1, 2, 3 });
+
+  edge_2.disconnect();
+  CHECK(middle.signal_detail_->forwards_.empty());
+  value = 0;
+  upstream(value);
+  CHECK(value == 2);
+}
+
+TEST_CASE("Test forward to a destroyed signal") {
+  signals2::signal2<void, int&> upstream;
+  signals2::connection edge;
+  int value = 0;
+  {
+    signals2::signal2<void, int&> downstream;
+    signals2::connection conn = downstream.connect([](int& v) { ++v; });
+    edge = upstream.forward_to(downstream);
+    upstream(value);
+    CHECK(value == 1);
+  }
+  upstream(value);
+  CHECK(value == 1);
+  CHECK(edge.connected());
+}
+
+TEST_CASE("Test forward disconnect during emission") {
+  signals2::signal2<void> upstream;
+  signals2::signal2<void> downstream;
+  int downstream_called_times = 0;
+  signals2::connection edge;
+  signals2::connection conn_up = upstream.connect([&edge] { edge.disconnect(); });
+  signals2::connection conn_down = downstream.connect([&downstream_called_times] { ++downstream_called_times; });
+  edge = upstream.forward_to(downstream);
+  upstream();
+  CHECK(downstream_called_times == 0);
+  CHECK(upstream.signal_detail_->forwards_.empty());
+
+  // An edge added by a slot starts forwarding with the next emission.
+  signals2::connection late_edge;
+  signals2::connection conn_add = upstream.connect([&] {
+    if (!late_edge.connected()) {
+      late_edge = upstream.forward_to(downstream);
+    }
+  });
+  upstream();
+  CHECK(downstream_called_times == 0);
+  upstream();
+  CHECK(downstream_called_times == 1);
+}
+
+TEST_CASE("Test forward edges in disconnect all") {
+  signals2::signal2<void> upstream;
+  signals2::signal2<void> downstream;
+  int downstream_called_times = 0;
+  signals2::connection conn_down = downstream.connect([&downstream_called_times] { ++downstream_called_times; });
+  std::vector<signals2::connection> connections;
+  connections.push_back(upstream.forward_to(downstream));
+  connections.push_back(upstream.connect([] {}));
+  signals2::disconnect_all(connections);
+  upstream();
+  CHECK(downstream_called_times == 0);
+  CHECK(upstream.signal_detail_->forwards_.empty());
+  CHECK(upstream.signal_detail_->connections_.empty());
+}
+
+namespace {
+
+struct CountedCopies {
+  CountedCopies() = default;
+  CountedCopies(const CountedCopies&) { ++copies; }
+  CountedCopies& operator=(const CountedCopies&) = default;
+
+  static inline int copies = 0;
+};
+
+}  // namespace
+
+TEST_CASE("Test by-value argument is copied once plus once per slot") {
+  signals2::signal2<void, CountedCopies> upstream;
+  signals2::signal2<void, CountedCopies> downstream;
+  std::vector<signals2::connection> connections;
+  connections.push_back(upstream.connect([](const CountedCopies&) {}));
+  connections.push_back(upstream.connect([](const CountedCopies&) {}));
+  const CountedCopies payload;
+  CountedCopies::copies = 0;
+  upstream(payload);
+  CHECK(CountedCopies::copies == 3);
+
+  // Forwarding passes the same copy on.
+  connections.push_back(upstream.forward_to(downstream));
+  connections.push_back(downstream.connect([](const CountedCopies&) {}));
+  CountedCopies::copies = 0;
+  upstream(payload);
+  CHECK(CountedCopies::copies == 4);
+}
@@ -0,0 +1,593 @@
+/**
+ * Benchmarks for state.h: notification fan-out, dependency tracking reads and
+ * computed propagation through chains, diamonds and wide fan-out. The ListView
+ * and Map pairs set the change records of state_vector.h and the per-key
+ * tracking of state_map.h against a state holding the whole container.
+ *
+ * Every graph is built and bound outside the timed loop; the loop only writes
+ * a source and lets propagation run. BenchMarkComputedFirstBind is the
+ * exception: it times bind() itself. Each write stores a different value, so
+ * the equality gate never short-circuits a measured update.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <signals/state.h>
+#include <signals/state_map.h>
+#include <signals/state_vector.h>
+#include "benchmark/benchmark.h"
+#include "bench_probe.h"
+#include "copy_probe.h"
+
+namespace {
+
+using int_computed = signals2::computed<int64_t>;
+
+std::unique_ptr<int_computed> MakeComputed() {
+  return std::make_unique<int_computed>();
+}
+
+// Stands in for a compute function running: after the first read it has
+// linked everything it reads.
+class SaturatedTracker final : public signals2::detail::dependency_tracker {
+public:
+  void on_dependency_changed(std::uint32_t) override {}
+  void refresh() override {}
+};
+
+}  // namespace
+
+void BenchMarkStateSet(benchmark::State& state) {
+  signals2::state<int64_t> source(0);
+  int64_t sink = 0;
+  std::vector<signals2::connection> conns;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    conns.push_back(source.connect([&sink](int64_t v) { sink += v; }));
+  }
+  int64_t value = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    source.set(++value);
+  }
+  benchmark::DoNotOptimize(sink);
+}
+
+BENCHMARK(BenchMarkStateSet)->Arg(0)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+void BenchMarkObservablePeek(benchmark::State& state) {
+  signals2::state<int64_t> source(1);
+  bench_probe probe(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(source.peek());
+  }
+}
+
+BENCHMARK(BenchMarkObservablePeek);
+
+// A read outside any compute function: what peek() costs plus one
+// thread_local load.
+void BenchMarkObservableGetUntracked(benchmark::State& state) {
+  signals2::state<int64_t> source(1);
+  bench_probe probe(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(source.get());
+  }
+}
+
+BENCHMARK(BenchMarkObservableGetUntracked);
+
+// A read inside a compute function, for a dependency that is already tracked.
+void BenchMarkObservableGetTracked(benchmark::State& state) {
+  signals2::state<int64_t> source(1);
+  SaturatedTracker tracker;
+  signals2::detail::tracking_scope scope(&tracker);
+  bench_probe probe(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(source.get());
+  }
+}
+
+BENCHMARK(BenchMarkObservableGetTracked);
+
+// source -> c1 -> c2 -> ... -> cN, one write propagates the whole chain.
+void BenchMarkComputedChain(benchmark::State& state) {
+  signals2::state<int64_t> source(0);
+  std::vector<std::unique_ptr<int_computed>> chain;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    chain.push_back(MakeComputed());
+    if (n == 0) {
+      chain.back()->bind([&source] { return source.get() + 1; });
+    } else {
+      int_computed& previous = *chain[static_cast<size_t>(n - 1)];
+      chain.back()->bind([&previous] { return previous.get() + 1; });
+    }
+  }
+  int64_t value = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    source.set(++value);
+  }
+  benchmark::DoNotOptimize(chain.back()->peek());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchMarkComputedChain)->RangeMultiplier(10)->Range(1, 1000);
+
+// source -> {b1 .. bN} -> sink: the sink depends on every branch.
+void BenchMarkComputedDiamond(benchmark::State& state) {
+  signals2::state<int64_t> source(0);
+  std::vector<std::unique_ptr<int_computed>> branches;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    branches.push_back(MakeComputed());
+    branches.back()->bind([&source, n] { return source.get() + n; });
+  }
+  int_computed sink;
+  sink.bind([&branches] {
+    int64_t sum = 0;
+    for (const std::unique_ptr<int_computed>& branch : branches) {
+      sum += branch->get();
+    }
+    return sum;
+  });
+  int64_t value = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    source.set(++value);
+  }
+  benchmark::DoNotOptimize(sink.peek());
+}
+
+BENCHMARK(BenchMarkComputedDiamond)->Arg(2)->Arg(8)->Arg(32);
+
+// One state read by N independent computeds.
+void BenchMarkComputedFanOut(benchmark::State& state) {
+  signals2::state<int64_t> source(0);
+  std::vector<std::unique_ptr<int_computed>> readers;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    readers.push_back(MakeComputed());
+    readers.back()->bind([&source, n] { return source.get() * n; });
+  }
+  int64_t value = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    source.set(++value);
+  }
+  benchmark::DoNotOptimize(readers.back()->peek());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchMarkComputedFanOut)->RangeMultiplier(10)->Range(1, 10000);
+
+// First bind of a computed summing N states: N dependency lookups that miss
+// and N subscriptions. Timed manually, so tearing the computed down again is
+// not included.
+void BenchMarkComputedFirstBind(benchmark::State& state) {
+  std::deque<signals2::state<int64_t>> inputs(static_cast<size_t>(state.range(0)));
+  bench_probe probe(state);
+  for (auto _ : state) {
+    int_computed sum;
+    const auto begin = std::chrono::steady_clock::now();
+    sum.bind([&inputs] {
+      int64_t total = 0;
+      for (const signals2::state<int64_t>& input : inputs) {
+        total += input.get();
+      }
+      return total;
+    });
+    const auto end = std::chrono::steady_clock::now();
+    state.SetIterationTime(std::chrono::duration<double>(end - begin).count());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchMarkComputedFirstBind)->RangeMultiplier(10)->Range(10, 10000)->UseManualTime();
+
+// mutate() on a large container with one subscriber; the mutation itself is
+// O(1), so what remains is the notification cost independent of size.
+void BenchMarkStateMutateLargeVector(benchmark::State& state) {
+  signals2::state<std::vector<int64_t>> source(std::vector<int64_t>(static_cast<size_t>(state.range(0))));
+  int64_t sink = 0;
+  signals2::connection conn = source.connect([&sink](const std::vector<int64_t>& v) { sink += v.front(); });
+  bench_probe probe(state);
+  for (auto _ : state) {
+    source.mutate([](std::vector<int64_t>& v) { ++v.front(); });
+  }
+  benchmark::DoNotOptimize(sink);
+}
+
+BENCHMARK(BenchMarkStateMutateLargeVector)->RangeMultiplier(100)->Range(1, 1000000);
+
+// A list view of N rows kept in sync while one row changes per update. The
+// state<std::vector> view gets the whole vector and rebuilds its rows; the
+// state_vector view applies the updated record to the one row.
+void BenchMarkListViewRebuild(benchmark::State& state) {
+  signals2::state<std::vector<int64_t>> rows(std::vector<int64_t>(static_cast<size_t>(state.range(0))));
+  std::vector<int64_t> view = rows.get();
+  signals2::connection conn = rows.connect([&view](const std::vector<int64_t>& all) { view.assign(all.begin(), all.end()); });
+  size_t next = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    rows.mutate([next](std::vector<int64_t>& all) { ++all[next]; });
+    next = (next + 1) % view.size();
+  }
+  benchmark::DoNotOptimize(view.data());
+}
+
+BENCHMARK(BenchMarkListViewRebuild)->RangeMultiplier(100)->Range(100, 10000);
+
+void BenchMarkListViewChangeRecords(benchmark::State& state) {
+  signals2::state_vector<int64_t> rows(std::vector<int64_t>(static_cast<size_t>(state.range(0))));
+  std::vector<int64_t> view = rows.get();
+  signals2::connection conn = rows.connect_changes(
+      [&view](const std::vector<int64_t>& all, std::span<const signals2::vector_change> changes) {
+        for (const signals2::vector_change& change : changes) {
+          if (change.type == signals2::vector_change::kind::updated) {
+            std::copy_n(all.begin() + static_cast<std::ptrdiff_t>(change.index), change.count,
+                        view.begin() + static_cast<std::ptrdiff_t>(change.index));
+          } else {
+            view = all;
+          }
+        }
+      });
+  size_t next = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    rows.mutate(next, [](int64_t& row) { ++row; });
+    next = (next + 1) % view.size();
+  }
+  benchmark::DoNotOptimize(view.data());
+}
+
+BENCHMARK(BenchMarkListViewChangeRecords)->RangeMultiplier(100)->Range(100, 10000);
+
+// N computeds, each reading one key of a map; one key is set per update. A
+// state holding the whole map wakes all N; a state_map wakes the one reading
+// the key.
+void BenchMarkMapWholeState(benchmark::State& state) {
+  const int64_t keys = state.range(0);
+  std::unordered_map<int64_t, int64_t> initial;
+  for (int64_t k = 0; k < keys; ++k) {
+    initial.emplace(k, 0);
+  }
+  signals2::state<std::unordered_map<int64_t, int64_t>> map(std::move(initial));
+  std::deque<int_computed> readers(static_cast<size_t>(keys));
+  for (int64_t k = 0; k < keys; ++k) {
+    readers[static_cast<size_t>(k)].bind([&map, k] { return map.get().at(k); });
+  }
+  int64_t next = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    map.mutate([next](std::unordered_map<int64_t, int64_t>& m) { ++m[next]; });
+    next = (next + 1) % keys;
+  }
+}
+
+BENCHMARK(BenchMarkMapWholeState)->RangeMultiplier(10)->Range(10, 1000);
+
+void BenchMarkMapPerKey(benchmark::State& state) {
+  const int64_t keys = state.range(0);
+  signals2::state_map<int64_t, int64_t> map;
+  for (int64_t k = 0; k < keys; ++k) {
+    map.set(k, 0);
+  }
+  std::deque<int_computed> readers(static_cast<size_t>(keys));
+  for (int64_t k = 0; k < keys; ++k) {
+    readers[static_cast<size_t>(k)].bind([&map, k] { return map.at(k); });
+  }
+  int64_t next = 0;
+  int64_t value = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    map.set(next, ++value);
+    next = (next + 1) % keys;
+  }
+}
+
+BENCHMARK(BenchMarkMapPerKey)->RangeMultiplier(10)->Range(10, 1000);
+
+// Loading a record: 30 states set in a row, each bound to a control, and a
+// computed summary reading all of them. Arg: 0 sets them one by one, 1 inside
+// one signals2::batch.
+void BenchMarkBatchLoadRecord(benchmark::State& state) {
+  constexpr int kFields = 30;
+  std::deque<signals2::state<int64_t>> fields;
+  for (int n = 0; n < kFields; ++n) {
+    fields.emplace_back(0);
+  }
+  int64_t repaints = 0;
+  std::vector<signals2::connection> conns;
+  for (signals2::state<int64_t>& field : fields) {
+    conns.push_back(field.connect([&repaints] { ++repaints; }));
+  }
+  int64_t summary_runs = 0;
+  int_computed summary;
+  summary.bind([&fields, &summary_runs] {
+    ++summary_runs;
+    int64_t sum = 0;
+    for (const signals2::state<int64_t>& field : fields) {
+      sum += field.get();
+    }
+    return sum;
+  });
+  conns.push_back(summary.connect([&repaints] { ++repaints; }));
+
+  const bool batched = state.range(0) != 0;
+  int64_t value = 0;
+  repaints = 0;
+  summary_runs = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    ++value;
+    if (batched) {
+      signals2::batch scope;
+      for (signals2::state<int64_t>& field : fields) {
+        field.set(value);
+      }
+    } else {
+      for (signals2::state<int64_t>& field : fields) {
+        field.set(value);
+      }
+    }
+  }
+  const double iterations = static_cast<double>(state.iterations());
+  state.counters["repaints_per_load"] = static_cast<double>(repaints) / iterations;
+  state.counters["recomputes_per_load"] = static_cast<double>(summary_runs) / iterations;
+}
+
+BENCHMARK(BenchMarkBatchLoadRecord)->ArgName("batched")->Arg(0)->Arg(1);
+
+// A hidden tab: N computeds over one state, nobody reading or observing
+// them. Arg 0 binds them as computed, 1 as lazy_computed after one read each
+// (so their dependency is tracked).
+void BenchMarkHiddenComputeds(benchmark::State& state) {
+  signals2::state<int64_t> source(0);
+  const bool lazy = state.range(1) != 0;
+  std::vector<std::unique_ptr<int_computed>> eager;
+  std::vector<std::unique_ptr<signals2::lazy_computed<int64_t>>> deferred;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    if (lazy) {
+      deferred.push_back(std::make_unique<signals2::lazy_computed<int64_t>>());
+      deferred.back()->bind([&source, n] { return source.get() * n; });
+      benchmark::DoNotOptimize(deferred.back()->get());
+    } else {
+      eager.push_back(MakeComputed());
+      eager.back()->bind([&source, n] { return source.get() * n; });
+    }
+  }
+  int64_t value = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    source.set(++value);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BenchMarkHiddenComputeds)->ArgNames({ "computeds", "lazy" })->ArgsProduct({ { 10, 1000 }, { 0, 1 } });
+
+// A filter over N sources that has shown every one of them once: it reads
+// only the selected source, then each iteration sets the next source in turn.
+// Dependencies the last pass did not read are dropped, so only one set in N
+// recomputes.
+void BenchMarkFilterOverSources(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  std::deque<signals2::state<int64_t>> sources(count);
+  signals2::state<size_t> selected(0);
+  int64_t runs = 0;
+  auto filter = MakeComputed();
+  filter->bind([&] {
+    ++runs;
+    return sources[selected.get()].get();
+  });
+  for (size_t n = 1; n < count; ++n) {
+    selected.set(n);
+  }
+  runs = 0;
+  int64_t value = 0;
+  size_t next = 0;
+  bench_probe probe(state);
+  for (auto _ : state) {
+    sources[next].set(++value);
+    next = next + 1 == count ? 0 : next + 1;
+  }
+  state.counters["recomputes_per_set"] = static_cast<double>(runs) / static_cast<double>(state.iterations());
+}
+
+BENCHMARK(BenchMarkFilterOverSources)->Arg(10)->Arg(500);
+
+// ---- Heavy values ----
+//
+// set(const T&) copies the value into the state once; emit() hands every
+// subscriber a const T&. A computed builds a new T per recompute and moves it
+// in. Args: subscribers.
+
+void BenchMarkStateSetCopyProbe(benchmark::State& state) {
+  signals2::state<CopyProbe> source;
+  std::vector<signals2::connection> conns;
+  int64_t total = 0;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    conns.push_back(source.connect([&total](const CopyProbe& p) { total += p.value; }));
+  }
+  CopyProbe next;
+  CopyCount copies(state);
+  for (auto _ : state) {
+    ++next.value;
+    source.set(next);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+BENCHMARK(BenchMarkStateSetCopyProbe)->Arg(1)->Arg(3)->Arg(10);
+
+void BenchMarkStateSetString(benchmark::State& state) {
+  signals2::state<std::string> source;
+  std::vector<signals2::connection> conns;
+  size_t total = 0;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    conns.push_back(source.connect([&total](const std::string& s) { total += s.size(); }));
+  }
+  std::string a(64, 'a');
+  std::string b(64, 'b');
+  bench_probe probe(state);
+  for (auto _ : state) {
+    source.set(a);
+    source.set(b);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+BENCHMARK(BenchMarkStateSetString)->Arg(1)->Arg(3)->Arg(10);
+
+void BenchMarkComputedCopyProbe(benchmark::State& state) {
+  signals2::state<int64_t> source(0);
+  signals2::computed<CopyProbe> derived;
+  derived.bind([&source] { return CopyProbe(source.get()); });
+  std::vector<signals2::connection> conns;
+  int64_t total = 0;
+  for (int64_t n = 0; n < state.range(0); ++n) {
+    conns.push_back(derived.connect([&total](const CopyProbe& p) { total += p.value; }));
+  }
+  int64_t value = 0;
+  CopyCount copies(state);
+  for (auto _ : state) {
+    source.set(++value);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+BENCHMARK(BenchMarkComputedCopyProbe)->Arg(1)->Arg(3)->Arg(10);
+
+// ---- UI view-model workload ----
+//
+// The shape described in docs/STATE_DESIGN_CONTEXT.md: panels holding a few
+// dozen states, computed values derived from them, computed labels formatted
+// from those, and controls bound through connect(). One iteration is one
+// frame: a burst of set() calls on random states of random panels, plus
+// closing some panels and opening new ones in their place.
+
+struct Control {
+  std::string text;
+  int64_t value = 0;
+  uint64_t repaints = 0;
+};
+
+class Panel {
+public:
+  static constexpr size_t kStates = 40;
+  static constexpr size_t kDerived = 10;
+  static constexpr size_t kLabels = 10;  // kDerived + kLabels computeds
+
+  explicit Panel(uint32_t seed) : controls_(kLabels + kStates / 4) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, kStates - 1);
+    for (size_t i = 0; i < kStates; ++i) {
+      states_.emplace_back(static_cast<int64_t>(i));
+    }
+    for (size_t i = 0; i < kDerived; ++i) {
+      signals2::state<int64_t>& a = states_[pick(rng)];
+      signals2::state<int64_t>& b = states_[pick(rng)];
+      signals2::state<int64_t>& c = states_[pick(rng)];
+      derived_.emplace_back();
+      derived_.back().bind([&a, &b, &c] { return a.get() + b.get() * c.get(); });
+    }
+    for (size_t i = 0; i < kLabels; ++i) {
+      int_computed& total = derived_[i];
+      signals2::state<int64_t>& count = states_[pick(rng)];
+      labels_.emplace_back();
+      labels_.back().bind([&total, &count] {
+        return "Total " + std::to_string(total.get()) + " of " + std::to_string(count.get());
+      });
+      Control& control = controls_[i];
+      conns_.push_back(labels_.back().connect([&control](const std::string& text) {
+        control.text = text;
+        ++control.repaints;
+      }));
+    }
+    // Every fourth state drives a control directly, like a checkbox or slider.
+    for (size_t i = 0; i < kStates / 4; ++i) {
+      Control& control = controls_[kLabels + i];
+      conns_.push_back(states_[i * 4].connect([&control](int64_t value) {
+        control.value = value;
+        ++control.repaints;
+      }));
+    }
+  }
+
+  void Set(size_t index, int64_t value) { states_[index].set(value); }
+
+  uint64_t Repaints() const {
+    uint64_t total = 0;
+    for (const Control& control : controls_) {
+      total += control.repaints;
+    }
+    return total;
+  }
+
+private:
+  std::deque<signals2::state<int64_t>> states_;
+  std::deque<int_computed> derived_;
+  std::deque<signals2::computed<std::string>> labels_;
+  std::vector<Control> controls_;
+  // Declared last: disconnects before the controls and values it refers to go.
+  std::vector<signals2::connection> conns_;
+};
+
+// Args: sets per frame, panels reopened per frame. 200 panels are open.
+void BenchMarkUiWorkload(benchmark::State& state) {
+  constexpr size_t kPanels = 200;
+  const int64_t sets_per_frame = state.range(0);
+  const int64_t reopen_per_frame = state.range(1);
+
+  const alloc_counter::snapshot before = alloc_counter::current();
+  std::mt19937 rng(42);
+  std::vector<std::unique_ptr<Panel>> panels;
+  for (size_t i = 0; i < kPanels; ++i) {
+    panels.push_back(std::make_unique<Panel>(static_cast<uint32_t>(rng())));
+  }
+  const int64_t model_bytes = alloc_counter::current().live_bytes - before.live_bytes;
+
+  std::uniform_int_distribution<size_t> pick_panel(0, kPanels - 1);
+  std::uniform_int_distribution<size_t> pick_state(0, Panel::kStates - 1);
+  std::uniform_int_distribution<int64_t> pick_value(0, 1000);
+  uint64_t closed_repaints = 0;
+  alloc_counter::reset_peak();
+  {
+    bench_probe probe(state);
+    for (auto _ : state) {
+      for (int64_t n = 0; n < reopen_per_frame; ++n) {
+        std::unique_ptr<Panel>& panel = panels[pick_panel(rng)];
+        closed_repaints += panel->Repaints();
+        panel.reset();
+        panel = std::make_unique<Panel>(static_cast<uint32_t>(rng()));
+      }
+      for (int64_t n = 0; n < sets_per_frame; ++n) {
+        panels[pick_panel(rng)]->Set(pick_state(rng), pick_value(rng));
+      }
+    }
+  }
+  uint64_t repaints = closed_repaints;
+  for (const std::unique_ptr<Panel>& panel : panels) {
+    repaints += panel->Repaints();
+  }
+  state.counters["repaints_per_frame"] =
+      benchmark::Counter(static_cast<double>(repaints), benchmark::Counter::kAvgIterations);
+  state.counters["model_bytes"] = static_cast<double>(model_bytes);
+  state.counters["peak_bytes"] = static_cast<double>(alloc_counter::current().peak_bytes - before.live_bytes);
+}
+
+BENCHMARK(BenchMarkUiWorkload)
+    ->ArgNames({ "sets", "reopen" })
+    ->Args({ 64, 0 })
+    ->Args({ 64, 1 })
+    ->Args({ 512, 0 })
+    ->Args({ 512, 4 })
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,207 @@
+/**
+ * @author McMurphy Luo
+ * @description Test cases for the observable map with per-key subscriptions (state_map.h)
+ */
+
+#include "catch_amalgamated.hpp"
+
+#include <signals/state_map.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using signals2::computed;
+using signals2::state_map;
+
+TEST_CASE("state_map notifies the subscribers of the changed key only") {
+  state_map<int, std::string> names;
+  names.set(1, "one");
+
+  std::vector<std::string> first;
+  int second_calls = 0;
+  std::vector<signals2::connection> conns;
+  conns.push_back(names.connect(1, [&](const std::string* v) { first.push_back(v ? *v : "<erased>"); }));
+  // A key that is not there yet.
+  conns.push_back(names.connect(2, [&] { ++second_calls; }));
+
+  names.set(1, "uno");
+  names.set(1, "uno");  // equal: nothing
+  names.set(3, "three");
+  CHECK(first == std::vector<std::string>{ "uno" });
+  CHECK(second_calls == 0);
+
+  names.set(2, "two");
+  CHECK(second_calls == 1);
+  CHECK(names.mutate(2, [](std::string& v) { v += "!"; }));
+  CHECK_FALSE(names.mutate(4, [](std::string&) {}));
+  CHECK(second_calls == 2);
+  CHECK(*names.peek(2) == "two!");
+
+  CHECK(names.erase(1));
+  CHECK_FALSE(names.erase(1));
+  CHECK(first == std::vector<std::string>{ "uno", "<erased>" });
+  CHECK(names.peek(1) == nullptr);
+
+  // Still subscribed to the erased key.
+  names.set(1, "again");
+  CHECK(first.back() == "again");
+  CHECK(names.size() == 3);
+}
+
+TEST_CASE("A computed reading one key recomputes only when that key changes") {
+  state_map<std::string, int> scores;
+  scores.set("ann", 1);
+  scores.set("bob", 2);
+
+  int ann_runs = 0;
+  computed<int> ann;
+  ann.bind([&] {
+    ++ann_runs;
+    return scores.at("ann") * 10;
+  });
+  int cid_runs = 0;
+  computed<int> cid;
+  cid.bind([&] {
+    ++cid_runs;
+    const int* score = scores.find("cid");
+    return score ? *score : -1;
+  });
+  CHECK(ann.get() == 10);
+  CHECK(cid.get() == -1);
+
+  scores.set("bob", 3);
+  CHECK(ann_runs == 1);
+  CHECK(cid_runs == 1);
+
+  scores.set("ann", 4);
+  CHECK(ann.get() == 40);
+  CHECK(ann_runs == 2);
+  CHECK(cid_runs == 1);
+
+  // The absent key was tracked: inserting it wakes the reader.
+  scores.set("cid", 7);
+  CHECK(cid.get() == 7);
+  CHECK(cid_runs == 2);
+  scores.erase("cid");
+  CHECK(cid.get() == -1);
+  CHECK(ann_runs == 2);
+
+  CHECK_THROWS_AS(scores.at("nobody"), std::out_of_range);
+  CHECK_FALSE(scores.contains("nobody"));
+}
+
+TEST_CASE("size() and for_each() track the key set") {
+  state_map<int, int> values;
+  values.set(1, 10);
+  values.set(2, 20);
+
+  int size_runs = 0;
+  computed<std::size_t> count;
+  count.bind([&] {
+    ++size_runs;
+    return values.size();
+  });
+  int total_runs = 0;
+  computed<int> total;
+  total.bind([&] {
+    ++total_runs;
+    int sum = 0;
+    values.for_each([&](int, int v) { sum += v; });
+    return sum;
+  });
+  CHECK(total.get() == 30);
+
+  values.set(2, 25);  // a value: total only
+  CHECK(total.get() == 35);
+  CHECK(size_runs == 1);
+  CHECK(total_runs == 2);
+
+  values.set(3, 5);  // a key: both
+  CHECK(count.get() == 3);
+  CHECK(total.get() == 40);
+  CHECK(size_runs == 2);
+  CHECK(total_runs == 3);
+
+  values.clear();
+  CHECK(count.get() == 0);
+  CHECK(total.get() == 0);
+  CHECK(values.empty());
+}
+
+TEST_CASE("Inserting a key read together with size() recomputes once") {
+  state_map<int, int> values;
+  std::vector<std::string> seen;
+  computed<std::string> summary;
+  summary.bind([&] {
+    const int* v = values.find(7);
+    return std::to_string(values.size()) + ":" + (v ? std::to_string(*v) : "-");
+  });
+  signals2::connection conn = summary.connect([&](const std::string& s) { seen.push_back(s); });
+
+  values.set(7, 1);
+  values.erase(7);
+  {
+    signals2::batch scope;
+    values.set(7, 2);
+    values.set(8, 3);
+  }
+  CHECK(seen == std::vector<std::string>{ "1:1", "0:-", "2:2" });
+}
+
+TEST_CASE("state_map drops empty cells nothing observes any more") {
+  state_map<int, int> values;
+  signals2::state<bool> wide(true);
+  computed<int> found;
+  found.bind([&] {
+    int hits = 0;
+    const int limit = wide.get() ? 1000 : 1;
+    for (int key = 0; key < limit; ++key) {
+      hits += values.contains(key) ? 1 : 0;
+    }
+    return hits;
+  });
+  CHECK(found.get() == 0);
+
+  // The 999 empty cells the first pass observed are released, then swept as
+  // new ones are created.
+  wide.set(false);
+  for (int key = 0; key < 2000; ++key) {
+    signals2::connection conn = values.connect(5000 + key, [] {});
+  }
+  values.set(0, 1);
+  CHECK(found.get() == 1);
+  values.set(500, 1);
+  CHECK(found.get() == 1);
+  wide.set(true);
+  CHECK(found.get() == 2);
+  values.erase(500);
+  CHECK(found.get() == 1);
+}
+
+TEST_CASE("connect() from a for_each() callback does not disturb the iteration") {
+  state_map<int, int> values;
+  for (int key = 0; key < 8; ++key) {
+    values.set(key, key);
+  }
+
+  std::vector<int> visited;
+  int notified = 0;
+  std::vector<signals2::connection> conns;
+  values.for_each([&](int key, int) {
+    visited.push_back(key);
+    // Enough new keys to rehash the table if they went straight in.
+    for (int i = 0; i < 64; ++i) {
+      conns.push_back(values.connect(1000 + 64 * key + i, [&] { ++notified; }));
+    }
+  });
+  std::sort(visited.begin(), visited.end());
+  CHECK(visited == std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7 });
+  CHECK(values.size() == 8);
+
+  values.set(1000, 1);
+  values.set(1000 + 64 * 7 + 63, 1);
+  CHECK(notified == 2);
+  CHECK(values.size() == 10);
+}
@@ -12,8 +12,11 @@
 #include <signals/state.h>
 
 #include <algorithm>
+#include <deque>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 using namespace signals2;
@@ -296,7 +299,7 @@ TEST_CASE("computed tracks a new branch and tolerates stale dependencies") {
   b.set(200);
   CHECK(pick.get() == 200);
 
-  a.set(50);  // stale dep -> recompute, same result
+  a.set(50);  // dependency dropped by the last pass -> ignored
   CHECK(pick.get() == 200);
 }
 
@@ -689,3 +692,392 @@ TEST_CASE("A callback argument equals get at invocation time") {
   CHECK(state.get() == 5);
   CHECK(calls == 5);
 }
+
+// ---- 23. a diamond recomputes its tip once, without a glitch -- invariant §2.7.2 ----
+TEST_CASE("A diamond recomputes its tip once per update") {
+  state<int> a(1);
+  computed<int> b;
+  computed<int> c;
+  computed<int> d;
+  int d_runs = 0;
+  b.bind([&] { return a.get() + 1; });
+  c.bind([&] { return a.get() * 10; });
+  d.bind([&] {
+    ++d_runs;
+    return b.get() + c.get();
+  });
+
+  std::vector<int> seen;
+  std::vector<signals2::connection> conns;
+  conns.push_back(d.connect([&](int v) { seen.push_back(v); }));
+
+  d_runs = 0;
+  a.set(2);
+  CHECK(d_runs == 1);
+  CHECK(seen == std::vector<int>{ 23 });
+
+  a.set(3);
+  CHECK(d_runs == 2);
+  CHECK(seen == std::vector<int>{ 23, 34 });
+}
+
+// ---- 24. uneven paths run in height order ----
+TEST_CASE("A computed waits for a deeper dependency on another path") {
+  state<int> a(1);
+  computed<int> b;
+  computed<int> c;
+  computed<int> sum;
+  b.bind([&] { return a.get() * 2; });
+  c.bind([&] { return b.get() * 2; });
+  std::vector<std::pair<int, int>> inputs;
+  sum.bind([&] {
+    inputs.emplace_back(a.get(), c.get());
+    return a.get() + c.get();
+  });
+
+  inputs.clear();
+  a.set(2);
+  CHECK(inputs == std::vector<std::pair<int, int>>{ { 2, 8 } });
+  CHECK(sum.get() == 10);
+}
+
+// ---- 25. reading a computed that is still queued ----
+TEST_CASE("get() of a queued computed returns the updated value") {
+  state<int> a(1);
+  computed<int> b;
+  computed<int> c;
+  b.bind([&] { return a.get() + 1; });
+  c.bind([&] { return a.get() + 2; });
+
+  std::vector<int> c_seen;
+  std::vector<signals2::connection> conns;
+  conns.push_back(b.connect([&] { c_seen.push_back(c.get()); }));
+  int c_notified = 0;
+  conns.push_back(c.connect([&] { ++c_notified; }));
+
+  a.set(5);
+  CHECK(c_seen == std::vector<int>{ 7 });
+  CHECK(c_notified == 1);
+}
+
+// ---- 26. a queued computed destroyed by a subscriber ----
+TEST_CASE("Destroying a queued computed during propagation is safe") {
+  state<int> a(1);
+  computed<int> first;
+  auto second = std::make_unique<computed<int>>();
+  first.bind([&] { return a.get() + 1; });
+  second->bind([&] { return a.get() + 2; });
+
+  std::vector<signals2::connection> conns;
+  conns.push_back(first.connect([&] { second.reset(); }));
+
+  a.set(2);
+  CHECK(first.get() == 3);
+  CHECK(second == nullptr);
+}
+
+// ---- 27. a batch notifies each changed observable once ----
+TEST_CASE("batch coalesces sets into one notification per state") {
+  state<int> a(0);
+  state<int> b(0);
+  computed<int> sum;
+  int sum_runs = 0;
+  sum.bind([&] {
+    ++sum_runs;
+    return a.get() + b.get();
+  });
+
+  std::vector<int> a_seen;
+  std::vector<int> sum_seen;
+  std::vector<signals2::connection> conns;
+  conns.push_back(a.connect([&](int v) { a_seen.push_back(v); }));
+  conns.push_back(sum.connect([&](int v) { sum_seen.push_back(v); }));
+
+  sum_runs = 0;
+  {
+    batch scope;
+    a.set(1);
+    a.set(2);
+    b.set(10);
+    CHECK(a.get() == 2);
+    CHECK(a_seen.empty());
+    CHECK(sum.get() == 0);
+  }
+  CHECK(a_seen == std::vector<int>{ 2 });
+  CHECK(sum_seen == std::vector<int>{ 12 });
+  CHECK(sum_runs == 1);
+}
+
+// ---- 28. only the outermost batch flushes ----
+TEST_CASE("Nested batches flush when the outermost one ends") {
+  state<int> a(0);
+  int calls = 0;
+  std::vector<signals2::connection> conns;
+  conns.push_back(a.connect([&] { ++calls; }));
+
+  {
+    batch outer;
+    {
+      batch inner;
+      a.set(1);
+    }
+    CHECK(calls == 0);
+    a.set(2);
+  }
+  CHECK(calls == 1);
+  CHECK(a.get() == 2);
+}
+
+// ---- 29. an observable destroyed inside a batch ----
+TEST_CASE("A state destroyed inside a batch is not notified") {
+  state<int> kept(0);
+  int calls = 0;
+  std::vector<signals2::connection> conns;
+  conns.push_back(kept.connect([&] { ++calls; }));
+
+  {
+    batch scope;
+    auto temporary = std::make_unique<state<int>>(0);
+    temporary->set(1);
+    kept.set(1);
+  }
+  CHECK(calls == 1);
+}
+
+// ---- 30. transaction is a batch around a callable ----
+TEST_CASE("transaction returns the callable's result after notifying") {
+  state<int> a(0);
+  std::vector<int> seen;
+  std::vector<signals2::connection> conns;
+  conns.push_back(a.connect([&](int v) { seen.push_back(v); }));
+
+  const int result = transaction([&] {
+    a.set(1);
+    a.set(3);
+    return a.get() * 2;
+  });
+  CHECK(result == 6);
+  CHECK(seen == std::vector<int>{ 3 });
+}
+
+// ---- 31. lazy_computed waits for a read while unobserved ----
+TEST_CASE("lazy_computed recomputes on read while nothing is connected") {
+  state<int> a(1);
+  lazy_computed<int> doubled;
+  int runs = 0;
+  doubled.bind([&] {
+    ++runs;
+    return a.get() * 2;
+  });
+  CHECK(runs == 0);
+
+  CHECK(doubled.get() == 2);
+  CHECK(runs == 1);
+  a.set(2);
+  a.set(3);
+  CHECK(runs == 1);
+  CHECK(doubled.peek() == 6);
+  CHECK(runs == 2);
+  CHECK(doubled.get() == 6);
+  CHECK(runs == 2);
+}
+
+// ---- 32. lazy_computed is eager while observed ----
+TEST_CASE("lazy_computed notifies its subscribers like computed") {
+  state<int> a(1);
+  lazy_computed<int> doubled;
+  doubled.bind([&] { return a.get() * 2; });
+  CHECK(doubled.get() == 2);
+
+  std::vector<int> seen;
+  {
+    std::vector<signals2::connection> conns;
+    conns.push_back(doubled.connect([&](int v) { seen.push_back(v); }));
+    a.set(2);
+    CHECK(seen == std::vector<int>{ 4 });
+  }
+
+  a.set(3);
+  CHECK(seen == std::vector<int>{ 4 });
+  CHECK(doubled.get() == 6);
+}
+
+// ---- 33. a computed reading a lazy_computed keeps it current ----
+TEST_CASE("A computed reading a lazy_computed sees every change") {
+  state<int> a(1);
+  lazy_computed<int> doubled;
+  computed<int> text_length;
+  doubled.bind([&] { return a.get() * 2; });
+  text_length.bind([&] { return static_cast<int>(std::to_string(doubled.get()).size()); });
+  CHECK(text_length.get() == 1);
+
+  a.set(50);
+  CHECK(doubled.peek() == 100);
+  CHECK(text_length.get() == 3);
+}
+
+// ---- 34. a dependency the last pass did not read is dropped ----
+TEST_CASE("A dependency left behind by a branch switch no longer recomputes") {
+  state<bool> use_a(true);
+  state<int> a(1);
+  state<int> b(100);
+  computed<int> pick;
+  int runs = 0;
+  pick.bind([&] {
+    ++runs;
+    return use_a.get() ? a.get() : b.get();
+  });
+  use_a.set(false);
+  CHECK(runs == 2);
+
+  a.set(2);
+  a.set(3);
+  CHECK(runs == 2);
+  b.set(200);
+  CHECK(runs == 3);
+
+  use_a.set(true);  // a is tracked again, b dropped
+  CHECK(pick.get() == 3);
+  b.set(300);
+  CHECK(runs == 4);
+  a.set(4);
+  CHECK(pick.get() == 4);
+  CHECK(runs == 5);
+}
+
+// ---- 35. a dependency dropped while it is emitting ----
+TEST_CASE("A dependency dropped during its own emission stops notifying") {
+  state<bool> use_a(true);
+  state<int> a(1);
+  state<int> b(100);
+  computed<int> pick;
+  std::vector<int> seen;
+  std::vector<signals2::connection> conns;
+  // The pass this pulls drops a while a is still emitting.
+  conns.push_back(a.connect([&](int) {
+    use_a.set(false);
+    seen.push_back(pick.get());
+  }));
+  int runs = 0;
+  pick.bind([&] {
+    ++runs;
+    return use_a.get() ? a.get() : b.get();
+  });
+
+  a.set(2);
+  CHECK(seen == std::vector<int>{ 100 });
+  CHECK(pick.get() == 100);
+  const int settled = runs;
+  a.set(3);
+  CHECK(runs == settled);
+}
+
+// ---- 36. destroying a computed while a dependency it dropped is emitting ----
+TEST_CASE("Destroying a computed in the middle of a dependency's emission is safe") {
+  state<bool> use_a(true);
+  state<int> a(1);
+  state<int> b(100);
+  auto pick = std::make_unique<computed<int>>();
+  std::vector<signals2::connection> conns;
+  conns.push_back(a.connect([&](int) {
+    if (!pick) {
+      return;
+    }
+    use_a.set(false);
+    CHECK(pick->get() == 100);
+    pick.reset();  // a's emission goes on after pick is gone
+  }));
+  pick->bind([&] { return use_a.get() ? a.get() : b.get(); });
+
+  a.set(2);
+  CHECK(!pick);
+  a.set(3);
+  b.set(200);
+}
+
+// ---- 37. a wide aggregation tracks each input once, across branch switches ----
+TEST_CASE("A computed over many states subscribes to each once") {
+  std::deque<state<int>> inputs;
+  for (int i = 0; i < 100; ++i) {
+    inputs.emplace_back(i);
+  }
+  state<int> limit(100);
+  computed<int> sum;
+  int runs = 0;
+  sum.bind([&] {
+    ++runs;
+    int total = 0;
+    for (int i = 0; i < limit.get(); ++i) {
+      total += inputs[static_cast<std::size_t>(i)].get() + inputs[0].get();
+    }
+    return total;
+  });
+  CHECK(sum.get() == 4950);
+
+  inputs[99].set(199);
+  CHECK(sum.get() == 5050);
+  CHECK(runs == 2);
+
+  limit.set(20);  // inputs 20..99 dropped
+  CHECK(sum.get() == 190);
+  inputs[50].set(0);
+  CHECK(runs == 3);
+  inputs[19].set(20);
+  CHECK(sum.get() == 191);
+  CHECK(runs == 4);
+
+  limit.set(60);  // tracked again
+  inputs[50].set(1);
+  CHECK(sum.get() == 1722);
+  CHECK(runs == 6);
+}
+
+// ---- 38. computeds are marked before any subscriber runs ----
+TEST_CASE("A subscriber connected before a computed bound reads it fresh") {
+  state<int> a(1);
+  computed<int> doubled;
+  std::vector<int> seen;
+  std::vector<signals2::connection> conns;
+  conns.push_back(a.connect([&](int) { seen.push_back(doubled.get()); }));
+  doubled.bind([&] { return a.get() * 2; });
+
+  a.set(2);
+  a.set(5);
+  CHECK(seen == std::vector<int>{ 4, 10 });
+}
+
+// ---- 39. unlinking one dependent leaves the others linked ----
+TEST_CASE("Destroying one of several computeds keeps the rest updating") {
+  state<int> a(1);
+  computed<int> plus_one;
+  auto plus_two = std::make_unique<computed<int>>();
+  computed<int> plus_three;
+  plus_one.bind([&] { return a.get() + 1; });
+  plus_two->bind([&] { return a.get() + 2; });
+  plus_three.bind([&] { return a.get() + 3; });
+
+  plus_two.reset();
+  a.set(10);
+  CHECK(plus_one.get() == 11);
+  CHECK(plus_three.get() == 13);
+
+  computed<int> plus_four;
+  plus_four.bind([&] { return a.get() + 4; });
+  a.set(20);
+  CHECK(plus_one.get() == 21);
+  CHECK(plus_three.get() == 23);
+  CHECK(plus_four.get() == 24);
+}
+
+// ---- 40. a lazy_computed connected before any read still notifies ----
+TEST_CASE("lazy_computed connected without a read notifies its subscribers") {
+  state<int> a(1);
+  lazy_computed<int> doubled;
+  doubled.bind([&] { return a.get() * 2; });
+
+  std::vector<int> seen;
+  signals2::connection conn = doubled.connect([&](int v) { seen.push_back(v); });
+  a.set(2);
+  a.set(3);
+  CHECK(seen == std::vector<int>{ 4, 6 });
+}
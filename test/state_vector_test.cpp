@@ -0,0 +1,244 @@
+/**
+ * @author McMurphy Luo
+ * @description Test cases for the observable vector with change records (state_vector.h)
+ */
+
+#include "catch_amalgamated.hpp"
+
+#include <signals/state_vector.h>
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+using signals2::vector_change;
+using kind = signals2::vector_change::kind;
+
+namespace {
+
+/// What a list view bound to the vector does: replays the records on its own
+/// copy, reloading on a reset.
+struct mirror {
+  std::vector<int> rows;
+  std::vector<vector_change> seen;
+
+  void apply(const std::vector<int>& all, std::span<const vector_change> changes) {
+    for (const vector_change& c : changes) {
+      seen.push_back(c);
+      const auto at = [this](std::size_t i) { return rows.begin() + static_cast<std::ptrdiff_t>(i); };
+      switch (c.type) {
+        case kind::inserted:
+          rows.insert(at(c.index), all.begin() + static_cast<std::ptrdiff_t>(c.index),
+                      all.begin() + static_cast<std::ptrdiff_t>(c.index + c.count));
+          break;
+        case kind::removed:
+          rows.erase(at(c.index), at(c.index + c.count));
+          break;
+        case kind::updated:
+          std::copy_n(all.begin() + static_cast<std::ptrdiff_t>(c.index), c.count, at(c.index));
+          break;
+        case kind::moved:
+          if (c.index < c.to) {
+            std::rotate(at(c.index), at(c.index + 1), at(c.to + 1));
+          } else {
+            std::rotate(at(c.to), at(c.index), at(c.index + 1));
+          }
+          break;
+        case kind::reset:
+          rows = all;
+          break;
+      }
+    }
+  }
+
+  signals2::connection attach(const signals2::state_vector<int>& source) {
+    rows = source.peek();
+    return source.connect_changes(
+        [this](const std::vector<int>& all, std::span<const vector_change> changes) { apply(all, changes); });
+  }
+};
+
+}  // namespace
+
+TEST_CASE("state_vector reports each operation as one record") {
+  signals2::state_vector<int> values({ 1, 2, 3 });
+  mirror view;
+  signals2::connection conn = view.attach(values);
+
+  values.push_back(4);
+  values.insert(0, 0);
+  values.erase(1, 2);
+  values.assign(0, 10);
+  values.move(0, 2);
+  values.mutate(1, [](int& v) { v *= 2; });
+  const std::vector<int> extra{ 7, 8 };
+  values.insert(1, extra.begin(), extra.end());
+
+  CHECK(view.seen == std::vector<vector_change>{
+                         { kind::inserted, 3, 1, 0 },
+                         { kind::inserted, 0, 1, 0 },
+                         { kind::removed, 1, 2, 0 },
+                         { kind::updated, 0, 1, 0 },
+                         { kind::moved, 0, 1, 2 },
+                         { kind::updated, 1, 1, 0 },
+                         { kind::inserted, 1, 2, 0 },
+                     });
+  CHECK(values.get() == std::vector<int>{ 3, 7, 8, 8, 10 });
+  CHECK(view.rows == values.get());
+
+  // An equal element or vector changes nothing.
+  values.assign(0, 3);
+  values.set({ 3, 7, 8, 8, 10 });
+  values.move(2, 2);
+  CHECK(view.seen.size() == 7);
+
+  values.set({ 1 });
+  values.clear();
+  CHECK(view.seen.back() == vector_change{ kind::removed, 0, 1, 0 });
+  CHECK(view.seen[view.seen.size() - 2] == vector_change{ kind::reset, 0, 0, 0 });
+  CHECK(view.rows.empty());
+}
+
+TEST_CASE("A batch merges adjacent records") {
+  signals2::state_vector<int> values({ 0, 1, 2, 3, 4, 5 });
+  mirror view;
+  signals2::connection conn = view.attach(values);
+  int calls = 0;
+  signals2::connection counter = values.connect([&] { ++calls; });
+
+  {
+    signals2::batch scope;
+    values.push_back(6);
+    values.push_back(7);
+    values.assign(7, 70);  // inside the inserted range: nothing new to say
+  }
+  CHECK(view.seen == std::vector<vector_change>{ { kind::inserted, 6, 2, 0 } });
+  CHECK(calls == 1);
+
+  view.seen.clear();
+  {
+    signals2::batch scope;
+    values.erase(2);  // forward delete
+    values.erase(2);
+    values.erase(1);  // backspace
+    values.assign(0, 10);
+    values.assign(1, 11);
+    values.assign(3, 13);  // not adjacent to [0, 2)
+  }
+  CHECK(view.seen == std::vector<vector_change>{
+                         { kind::removed, 1, 3, 0 },
+                         { kind::updated, 0, 2, 0 },
+                         { kind::updated, 3, 1, 0 },
+                     });
+  CHECK(view.rows == values.get());
+
+  view.seen.clear();
+  {
+    signals2::batch scope;
+    values.push_back(1);
+    values.set({ 9, 9 });  // everything before it is moot
+    values.push_back(9);
+  }
+  CHECK(view.seen == std::vector<vector_change>{ { kind::reset, 0, 0, 0 } });
+  CHECK(view.rows == std::vector<int>{ 9, 9, 9 });
+}
+
+TEST_CASE("state_vector is an observable for connect and computed") {
+  signals2::state_vector<int> values;
+  signals2::computed<int> total;
+  total.bind([&] {
+    int sum = 0;
+    for (int v : values.get()) {
+      sum += v;
+    }
+    return sum;
+  });
+  signals2::computed<std::size_t> count;
+  count.bind([&] { return values.size(); });
+
+  std::vector<std::size_t> sizes;
+  signals2::connection conn = values.connect([&](const std::vector<int>& v) { sizes.push_back(v.size()); });
+
+  values.push_back(2);
+  values.push_back(3);
+  values.assign(0, 5);
+  CHECK(total.get() == 8);
+  CHECK(count.get() == 2);
+  CHECK(values[0] == 5);
+  CHECK(sizes == std::vector<std::size_t>{ 1, 2, 2 });
+}
+
+TEST_CASE("A subscriber changing the vector leaves every subscriber consistent") {
+  signals2::state_vector<int> values;
+  mirror first;
+  mirror last;
+  std::vector<signals2::connection> conns;
+  conns.push_back(first.attach(values));
+  // Keeps the vector at an even length.
+  conns.push_back(values.connect_changes([&](const std::vector<int>& all, std::span<const vector_change>) {
+    if (all.size() % 2 != 0) {
+      values.push_back(0);
+    }
+  }));
+  conns.push_back(last.attach(values));
+
+  values.push_back(1);
+  values.push_back(2);
+  values.insert(1, 3);
+
+  CHECK(values.get() == std::vector<int>{ 1, 3, 0, 2, 0, 0 });
+  CHECK(first.rows == values.get());
+  CHECK(last.rows == values.get());
+  // The last subscriber missed the round the fix-up ended, and gets its
+  // record with the fix-up's in the next one. The first had already seen it,
+  // so the two stay separate.
+  REQUIRE(last.seen.size() >= 2);
+  CHECK(last.seen[0] == vector_change{ kind::inserted, 0, 1, 0 });
+  CHECK(last.seen[1] == vector_change{ kind::inserted, 1, 1, 0 });
+}
+
+TEST_CASE("notify() and a skipped round reach change subscribers as a reset") {
+  signals2::state_vector<int> values({ 1 });
+  mirror view;
+  std::vector<signals2::connection> conns;
+  bool fail = false;
+  conns.push_back(values.connect_changes([&](const std::vector<int>&, std::span<const vector_change>) {
+    if (fail) {
+      throw std::runtime_error("subscriber failed");
+    }
+  }));
+  conns.push_back(view.attach(values));
+
+  values.notify();
+  CHECK(view.seen == std::vector<vector_change>{ { kind::reset, 0, 0, 0 } });
+
+  view.seen.clear();
+  fail = true;
+  CHECK_THROWS(values.push_back(2));
+  CHECK(view.seen.empty());
+
+  fail = false;
+  values.push_back(3);
+  CHECK(view.seen == std::vector<vector_change>{ { kind::reset, 0, 0, 0 } });
+  CHECK(view.rows == std::vector<int>{ 1, 2, 3 });
+}
+
+TEST_CASE("A change made after a reset reaches later subscribers inside the reset") {
+  signals2::state_vector<int> values({ 1, 2 });
+  std::vector<signals2::connection> conns;
+  bool appended = false;
+  conns.push_back(values.connect_changes([&](const std::vector<int>&, std::span<const vector_change>) {
+    if (!appended) {
+      appended = true;
+      values.push_back(3);
+    }
+  }));
+  mirror view;
+  conns.push_back(view.attach(values));
+
+  values.set({ 7 });
+  CHECK(values.get() == std::vector<int>{ 7, 3 });
+  CHECK(view.rows == values.get());
+  CHECK(view.seen == std::vector<vector_change>{ { kind::reset, 0, 0, 0 } });
+}
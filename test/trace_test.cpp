@@ -0,0 +1,156 @@
+/**
+ * @author McMurphy Luo
+ * @description Test cases for the Chrome trace-event writer (trace.h)
+ *
+ * Built into signals2_instrument_tests, which defines SIGNALS2_INSTRUMENT.
+ */
+
+#include "catch_amalgamated.hpp"
+
+#include <signals/state.h>
+#include <signals/trace.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::size_t count_occurrences(const std::string& text, const std::string& needle) {
+  std::size_t count = 0;
+  for (std::size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+/// The text after every occurrence of @p key, up to the next ',' or '}'.
+std::vector<std::string> field_values(const std::string& json, const std::string& key) {
+  std::vector<std::string> values;
+  for (std::size_t pos = json.find(key); pos != std::string::npos; pos = json.find(key, pos + 1)) {
+    const std::size_t begin = pos + key.size();
+    values.push_back(json.substr(begin, json.find_first_of(",}", begin) - begin));
+  }
+  return values;
+}
+
+std::string flush_trace() {
+  std::ostringstream out;
+  signals2::trace::write_chrome_json(out);
+  return out.str();
+}
+
+}  // namespace
+
+TEST_CASE("trace records named signal emissions with their slot count") {
+  signals2::trace::clear();
+  signals2::signal2<void> upstream;
+  signals2::signal2<void> downstream;
+  upstream.set_name("frame \"tick\"");
+  signals2::connection edge = upstream.forward_to(downstream);
+  signals2::connection conn_1 = upstream.connect([] {});
+  signals2::connection conn_2 = upstream.connect([] {});
+
+  upstream();  // before start(): not recorded
+  signals2::trace::start(16);
+  upstream();
+  signals2::trace::stop();
+  upstream();  // after stop(): not recorded
+
+  const std::string json = flush_trace();
+  CHECK(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+  CHECK(count_occurrences(json, "\"ph\":\"X\"") == 2);
+  CHECK(count_occurrences(json, "\"name\":\"frame \\\"tick\\\"\"") == 1);
+  CHECK(count_occurrences(json, "\"name\":\"signal\"") == 1);
+  CHECK(count_occurrences(json, "\"slots\":2") == 1);
+  CHECK(count_occurrences(json, "\"slots\":0") == 1);
+}
+
+TEST_CASE("trace records state notifications and recompute passes") {
+  signals2::trace::clear();
+  signals2::state<int> source(1);
+  signals2::computed<int> doubled;
+  doubled.bind([&] { return source.get() * 2; });
+
+  signals2::trace::start(16);
+  source.set(2);
+  signals2::trace::stop();
+
+  const std::string json = flush_trace();
+  CHECK(doubled.get() == 4);
+  CHECK(count_occurrences(json, "\"name\":\"observable::emit\"") == 2);
+  CHECK(count_occurrences(json, "\"name\":\"computed::recompute\"") == 1);
+}
+
+TEST_CASE("trace keeps the most recent events when the ring buffer wraps") {
+  signals2::trace::clear();
+  signals2::signal2<void> test_signal;
+  signals2::connection conn = test_signal.connect([] {});
+  signals2::trace::start(16);
+  for (int i = 0; i < 40; ++i) {
+    test_signal();
+  }
+  signals2::trace::stop();
+  CHECK(count_occurrences(flush_trace(), "\"ph\":\"X\"") == 16);
+}
+
+TEST_CASE("A second trace::start() does nothing until stop()") {
+  signals2::trace::clear();
+  signals2::signal2<void> test_signal;
+  signals2::connection conn = test_signal.connect([] {});
+  signals2::trace::start(16);
+  signals2::trace::start(16);
+  test_signal();
+  signals2::trace::stop();
+  test_signal();  // the hooks from before the first start(): not recorded
+  CHECK(count_occurrences(flush_trace(), "\"ph\":\"X\"") == 1);
+}
+
+TEST_CASE("trace keeps nanosecond timestamps more than a second into the session") {
+  signals2::trace::clear();
+  signals2::signal2<void> upstream;
+  signals2::signal2<void> downstream;
+  signals2::connection edge = upstream.forward_to(downstream);
+  signals2::connection conn = downstream.connect([] {});
+  signals2::trace::start(16);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  upstream();
+  signals2::trace::stop();
+
+  const std::string json = flush_trace();
+  const std::vector<std::string> ts = field_values(json, "\"ts\":");
+  const std::vector<std::string> dur = field_values(json, "\"dur\":");
+  REQUIRE(ts.size() == 2);
+  REQUIRE(dur.size() == 2);
+  for (const std::string& value : ts) {
+    INFO(value);
+    CHECK(value.find('e') == std::string::npos);
+    CHECK(value.size() - value.find('.') == 4);
+  }
+  // The forwarded emission ends first, so it is written first.
+  const double inner_ts = std::strtod(ts[0].c_str(), nullptr);
+  const double outer_ts = std::strtod(ts[1].c_str(), nullptr);
+  const double inner_end = inner_ts + std::strtod(dur[0].c_str(), nullptr);
+  const double outer_end = outer_ts + std::strtod(dur[1].c_str(), nullptr);
+  CHECK(outer_ts > 1e6);
+  CHECK(outer_ts <= inner_ts);
+  CHECK(inner_ts < inner_end);
+  CHECK(inner_end <= outer_end);
+}
+
+TEST_CASE("A span left open by trace::stop() does not carry into the next start()") {
+  signals2::trace::clear();
+  signals2::signal2<void> stopper;
+  signals2::signal2<void> starter;
+  signals2::connection stop_conn = stopper.connect([] { signals2::trace::stop(); });
+  signals2::connection start_conn = starter.connect([] { signals2::trace::start(16); });
+
+  signals2::trace::start(16);
+  stopper();  // its span is still open when the hooks are removed
+  starter();  // begun unrecorded; its end must not close the stale span
+  signals2::trace::stop();
+  CHECK(count_occurrences(flush_trace(), "\"ph\":\"X\"") == 0);
+}